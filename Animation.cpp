@@ -0,0 +1,222 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "Animation.h"
+
+Animation::Animation(Scheduler* scheduler, uint8_t timer) :
+	_scheduler(scheduler),
+	_timer(timer),
+	_numberOfWaiting(0),
+	_step(nullptr),
+	_argument(0),
+	_repeatStep(nullptr),
+	_repeatCount(0),
+	_beat(0),
+	_keyframeTime(0),
+	_audioStartTime(0),
+	_audioStarted(false),
+	_syncTimeout(0),
+	_waitingForSync(false)
+{
+}
+
+Animation::~Animation()
+{
+}
+
+void Animation::setBeat(unsigned int beat)
+{
+	_beat = beat;
+}
+
+void Animation::setSyncTimeout(unsigned int timeout)
+{
+	_syncTimeout = timeout;
+}
+
+void Animation::setAudioStart(unsigned long time)
+{
+	_audioStartTime	= time;
+	_audioStarted	= true;
+
+	if (isRunning())
+	{
+		wake();
+	}
+}
+
+bool Animation::play(const uint8_t* sequence, uint8_t argument)
+{
+	if (_numberOfWaiting == nAnimationSequences)
+	{
+		return false;
+	}
+
+	_waiting[_numberOfWaiting].steps	= sequence;
+	_waiting[_numberOfWaiting].argument	= argument;
+	_numberOfWaiting++;
+
+	// If the previous sequence has finished, start the new one from the current time.
+	if (!isRunning())
+	{
+		_keyframeTime = HAL::millis();
+		startNextSequence();
+		wake();
+	}
+
+	return true;
+}
+
+void Animation::clear()
+{
+	_numberOfWaiting	= 0;
+	_step				= nullptr;
+	_audioStarted		= false;
+	_waitingForSync		= false;
+	_scheduler->cancel(_timer);
+}
+
+bool Animation::isRunning()
+{
+	return _step != nullptr;
+}
+
+bool Animation::getNextKeyframe(Keyframe& keyframe)
+{
+	while (_step != nullptr)
+	{
+		uint8_t code	= HAL::readProgramMemory(_step);
+		uint8_t value	= HAL::readProgramMemory(_step + 1);
+
+		ANIMATION::ACTION action = (ANIMATION::ACTION)(code & 0x0F);
+
+		// The flow control steps take no time, so they are handled straight away.
+		switch (action)
+		{
+			case ANIMATION::END:
+			{
+				startNextSequence();
+				continue;
+			}
+
+			case ANIMATION::REPEAT:
+			{
+				_step			+= 2;
+				_repeatStep		= _step;
+				_repeatCount	= value;
+				continue;
+			}
+
+			case ANIMATION::LOOP:
+			{
+				if (_repeatCount > 1)
+				{
+					_repeatCount--;
+					_step = _repeatStep;
+				}
+				else
+				{
+					_step += 2;
+				}
+				continue;
+			}
+
+			case ANIMATION::SYNC:
+			{
+				if (_audioStarted)
+				{
+					_keyframeTime = _audioStartTime;
+				}
+				else
+				{
+					if (!_waitingForSync)
+					{
+						_waitingForSync	= true;
+						_keyframeTime	= HAL::millis();
+					}
+
+					if (HAL::millis() - _keyframeTime < _syncTimeout)
+					{
+						_scheduler->schedule(_timer, _keyframeTime + _syncTimeout);
+						return false;
+					}
+
+					// The sound never started.  Carry on as if it had when the wait ran out.
+					_keyframeTime += _syncTimeout;
+				}
+
+				_audioStarted	= false;
+				_waitingForSync	= false;
+				_step		   += 2;
+				continue;
+			}
+
+			default:
+			{
+				break;
+			}
+		}
+
+		unsigned int delay = (code >> 4) * _beat;
+
+		// The difference is taken as signed, which handles both the roll over of millis and a previous step time in the
+		// future (a sound that hasn't started yet).
+		if ((long)(HAL::millis() - _keyframeTime) < (long)delay)
+		{
+			_scheduler->schedule(_timer, _keyframeTime + delay);
+			return false;
+		}
+
+		keyframe.delay	= delay;
+		keyframe.action	= action;
+		keyframe.value	= value == ANIMATION::ARGUMENT ? _argument : value;
+
+		_keyframeTime  += delay;
+		_step		   += 2;
+
+		return true;
+	}
+
+	_scheduler->cancel(_timer);
+	return false;
+}
+
+void Animation::startNextSequence()
+{
+	if (_numberOfWaiting == 0)
+	{
+		_step = nullptr;
+		return;
+	}
+
+	_step			= _waiting[0].steps;
+	_argument		= _waiting[0].argument;
+	_audioStarted	= false;
+	_waitingForSync	= false;
+
+	_numberOfWaiting--;
+	for (uint8_t i = 0; i < _numberOfWaiting; i++)
+	{
+		_waiting[i] = _waiting[i+1];
+	}
+}
+
+void Animation::wake()
+{
+	_scheduler->schedule(_timer, HAL::millis());
+}
@@ -0,0 +1,136 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include "HardwareAbstraction.h"
+#include "enums.h"
+#include "Scheduler.h"
+
+// Maximum number of sequences that can be waiting to play after the current one.
+#define nAnimationSequences 4
+
+// Light sequences are stored in flash as a list of two byte steps, the last of which is an END step.  The first byte
+// has the delay before the step in the high 4 bits and the action in the low 4 bits.  The second byte is the value.
+// The delay is a number of beats (see setBeat), so a sequence plays at the same tempo as the rest of the generator.
+//
+// The sequences are written as text in LightSequences.txt and compiled into LightSequences.h with the sequence
+// compiler of the simulator.  Use this to write a step by hand.
+#define animationStep(delay, action, value) (uint8_t)((delay) << 4 | (action)), (uint8_t)(value)
+
+// A single step in a light sequence, as it is handed to the generator.  The delay is the time (milliseconds) waited
+// after the previous step before the action is applied.
+struct Keyframe
+{
+	unsigned int										delay;
+	ANIMATION::ACTION									action;
+	uint8_t												value;
+};
+
+// Plays the light sequences in flash without blocking.  Sequences start playing as soon as they are added and sequences
+// added while one is playing are played after it.  The animation keeps a timer of the scheduler set to when the next
+// step is due.  When it runs, call getNextKeyframe to retrieve the steps that are due.  Only a few bytes of SRAM are used,
+// however long the sequences are.
+//
+// Light cues are tied to sounds with a SYNC step.  The steps after it are timed from the moment the sound started (see
+// setAudioStart), not from the step before, so they land with the sound however long the audio board took to start it.
+// The start may be reported before the SYNC step is reached (a trigger pulse, whose start is known ahead of time) or
+// after (an answer from the board), but only starts reported while the sequence is playing count.  If no sound starts
+// within the sync timeout, the sequence carries on as if one had started then.
+class Animation
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		// "Timer" is the timer of the scheduler that is set to the time of the next step.
+		Animation(Scheduler* scheduler, uint8_t timer);
+
+		// Default destructor.
+		~Animation();
+
+	// Public interface.
+	public:
+		// The length of a beat (milliseconds).  The step delays are counted in beats.
+		void setBeat(unsigned int beat);
+
+		// How long (milliseconds) a SYNC step waits for a sound to start.
+		void setSyncTimeout(unsigned int timeout);
+
+		// A sound started (or will start) at "time" (milliseconds, same clock as millis).
+		void setAudioStart(unsigned long time);
+
+		// Add a sequence (in flash) to play.  Step values of ANIMATION::ARGUMENT are replaced by "argument."  Returns false
+		// if there are too many sequences waiting.
+		bool play(const uint8_t* sequence, uint8_t argument = 0);
+
+		// Stop playing and remove all waiting sequences.
+		void clear();
+
+		// True if there are steps waiting to be applied.
+		bool isRunning();
+
+		// If a step is due, it is copied into "keyframe" and true is returned.  Call repeatedly until it returns false
+		// to catch up on all steps that are due.
+		bool getNextKeyframe(Keyframe& keyframe);
+
+	private:
+		// Start the next waiting sequence, if there is one.
+		void startNextSequence();
+
+		// Have getNextKeyframe called right away, to start a sequence or pick up a sound that started.
+		void wake();
+
+	private:
+		Scheduler*											_scheduler;
+		uint8_t												_timer;
+
+		struct Sequence
+		{
+			const uint8_t*									steps;
+			uint8_t											argument;
+		};
+
+		Sequence											_waiting[nAnimationSequences];
+		uint8_t												_numberOfWaiting;
+
+		// The next step of the sequence that is playing (nullptr if none is).
+		const uint8_t*										_step;
+		uint8_t												_argument;
+
+		// The first step of the repeat and the number of times it is still to be played.
+		const uint8_t*										_repeatStep;
+		uint8_t												_repeatCount;
+
+		unsigned int										_beat;
+
+		// The time the previous step was due.  Deadlines are kept relative to this (and not the time the step was
+		// actually applied) so that a late loop does not stretch out the sequence.  It can be in the future when a
+		// SYNC step is anchored to a sound that hasn't started yet.  While waiting at a SYNC step, it is the time the
+		// wait started.
+		unsigned long										_keyframeTime;
+
+		// The start of the latest sound, if one was reported since the sequence started or the last SYNC step.
+		unsigned long										_audioStartTime;
+		bool												_audioStarted;
+
+		unsigned int										_syncTimeout;
+		bool												_waitingForSync;
+};
+
+#endif
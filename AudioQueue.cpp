@@ -0,0 +1,277 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "AudioQueue.h"
+
+AudioQueue::AudioQueue(HAL::AudioSerial* serial) :
+	_serial(serial),
+	_replyTimeout(0),
+	_byteDelay(0),
+	_numberOfCommands(0),
+	_state(AUDIOCOMMAND::IDLE),
+	_sendPosition(0),
+	_sentTime(0),
+	_playing(false),
+	_playingCommand(),
+	_reply(0),
+	_startTime(0),
+	_started(false),
+	_counters()
+{
+}
+
+AudioQueue::~AudioQueue()
+{
+}
+
+void AudioQueue::begin(unsigned int replyTimeout, unsigned int byteDelay)
+{
+	_replyTimeout	= replyTimeout;
+	_byteDelay		= byteDelay;
+
+	while (_serial->available() > 0)
+	{
+		_serial->read();
+	}
+}
+
+bool AudioQueue::play(const char* file, AUDIOCOMMAND::PRIORITY priority, bool repeat)
+{
+	// Less important sounds still waiting are out of date now.  A command that is being sent or answered is left to
+	// finish, the new sound replaces it afterwards.
+	uint8_t first	= _state == AUDIOCOMMAND::IDLE ? 0 : 1;
+	uint8_t kept	= first;
+
+	for (uint8_t i = first; i < _numberOfCommands; i++)
+	{
+		if (_commands[i].priority >= priority)
+		{
+			_commands[kept++] = _commands[i];
+		}
+		else
+		{
+			_counters.dropped++;
+		}
+	}
+	_numberOfCommands = kept;
+
+	if (_numberOfCommands == nAudioCommands)
+	{
+		_counters.dropped++;
+		return false;
+	}
+
+	_commands[_numberOfCommands].file		= file;
+	_commands[_numberOfCommands].priority	= priority;
+	_commands[_numberOfCommands].repeat		= repeat;
+	_numberOfCommands++;
+	return true;
+}
+
+void AudioQueue::update()
+{
+	readReplies();
+
+	switch (_state)
+	{
+		case AUDIOCOMMAND::IDLE:
+		{
+			startNextCommand();
+			break;
+		}
+
+		case AUDIOCOMMAND::SENDING:
+		{
+			sendNextByte();
+			break;
+		}
+
+		case AUDIOCOMMAND::WAITING:
+		{
+			// No answer.  Assume the board isn't playing anything, so a lost reply can't hold up the sounds behind it.
+			if (HAL::millis() - _sentTime >= _replyTimeout)
+			{
+				_counters.timeouts++;
+				_playing = false;
+				finishCommand();
+			}
+			break;
+		}
+	}
+}
+
+bool AudioQueue::isPlaying()
+{
+	return _playing;
+}
+
+bool AudioQueue::getStart(unsigned long& time)
+{
+	if (!_started)
+	{
+		return false;
+	}
+
+	time		= _startTime;
+	_started	= false;
+	return true;
+}
+
+AUDIOCOMMAND::STATE AudioQueue::getState()
+{
+	return _state;
+}
+
+const AudioQueue::Counters& AudioQueue::getCounters()
+{
+	return _counters;
+}
+
+void AudioQueue::startNextCommand()
+{
+	if (_numberOfCommands == 0)
+	{
+		return;
+	}
+
+	// Wait for a more important sound to finish.
+	if (_playing && _commands[0].priority < _playingCommand.priority)
+	{
+		return;
+	}
+
+	_state			= AUDIOCOMMAND::SENDING;
+	_sendPosition	= 0;
+}
+
+// One byte of "P<file>\n" per call.  Writing a byte blocks for its transmission time (about a millisecond at
+// 9600 baud), so this is as much as a pass through the loop can afford.
+void AudioQueue::sendNextByte()
+{
+	if (_sendPosition > 0 && HAL::millis() - _sentTime < _byteDelay)
+	{
+		return;
+	}
+
+	char value;
+
+	if (_sendPosition == 0)
+	{
+		value = 'P';
+	}
+	else
+	{
+		value = HAL::readProgramMemory(_commands[0].file + _sendPosition - 1);
+		if (value == '\0')
+		{
+			value = '\n';
+		}
+	}
+
+	_serial->write(value);
+	_sendPosition++;
+	_sentTime = HAL::millis();
+
+	if (value == '\n')
+	{
+		_state = AUDIOCOMMAND::WAITING;
+	}
+}
+
+void AudioQueue::finishCommand()
+{
+	_numberOfCommands--;
+	for (uint8_t i = 0; i < _numberOfCommands; i++)
+	{
+		_commands[i] = _commands[i+1];
+	}
+	_state = AUDIOCOMMAND::IDLE;
+}
+
+void AudioQueue::readReplies()
+{
+	while (_serial->available() > 0)
+	{
+		char value = _serial->read();
+
+		if (value == '\n')
+		{
+			_reply = 0;
+		}
+		else if (_reply == 0 && value != '\r')
+		{
+			_reply = value;
+			handleReply(_reply);
+		}
+	}
+}
+
+void AudioQueue::handleReply(char reply)
+{
+	switch (reply)
+	{
+		// "play <track> <file>"
+		case 'p':
+		{
+			if (_state == AUDIOCOMMAND::WAITING)
+			{
+				_playing		= true;
+				_playingCommand	= _commands[0];
+				_counters.played++;
+
+				if (!_playingCommand.repeat)
+				{
+					_startTime	= HAL::millis();
+					_started	= true;
+				}
+				finishCommand();
+			}
+			break;
+		}
+
+		// "NoFile"
+		case 'N':
+		{
+			if (_state == AUDIOCOMMAND::WAITING)
+			{
+				_counters.missing++;
+				finishCommand();
+			}
+			break;
+		}
+
+		// "done", the file finished.  The hum is started again if nothing else is waiting.
+		case 'd':
+		{
+			if (_playing)
+			{
+				_playing = false;
+				if (_playingCommand.repeat && _numberOfCommands == 0)
+				{
+					play(_playingCommand.file, _playingCommand.priority, true);
+				}
+			}
+			break;
+		}
+
+		default:
+		{
+			break;
+		}
+	}
+}
@@ -0,0 +1,131 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef AUDIOQUEUE_H
+#define AUDIOQUEUE_H
+
+#include "HardwareAbstraction.h"
+#include "enums.h"
+
+// Maximum number of sounds that can wait to be played.
+#define nAudioCommands 4
+
+// Plays files on the audio board (VS1000 in UART mode) without blocking.  Sounds are queued with play, and update sends
+// the commands a byte at a time and reads the board's replies as they arrive, so a pass through the loop never waits on
+// the board for longer than it takes to send one byte.  The bytes can be spaced out further, to limit how often the
+// serial port holds up the interrupts.
+//
+// The board plays one file at a time and starting a file stops the one playing.  A sound of the same or higher priority
+// than the one playing is started right away.  A sound of lower priority waits for the one playing to finish.  If the board doesn't answer a command
+// within the reply timeout, the command is given up on so the sounds behind it aren't held up.  A repeating sound (the
+// hum) is started again each time it finishes, as long as nothing else is waiting to play.
+//
+// The command to play a file is the line "P<file>".  The board answers with "play <track> <file>" or "NoFile", and sends
+// "done" when the file finishes.  The replies are told apart by their first character, so each is acted on as soon as
+// that arrives and the rest of the line (about 20 milliseconds of it at 9600 baud) is skipped.
+class AudioQueue
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		AudioQueue(HAL::AudioSerial* serial);
+
+		// Default destructor.
+		~AudioQueue();
+
+	// Public interface.
+	public:
+		// Start talking to the board.  Call once the serial port is running and the board has started.  Anything the board
+		// sent while starting up is thrown away.  "replyTimeout" is how long (milliseconds) to wait for an answer and
+		// "byteDelay" is the least time (milliseconds) between the bytes of a command.
+		void begin(unsigned int replyTimeout, unsigned int byteDelay = 0);
+
+		// Queue a file to play.  The name is in program memory, in 8.3 form without the dot (e.g. "STATECHGOGG").  Sounds
+		// of lower priority still waiting in the queue are dropped.  Returns false if the queue is full.
+		bool play(const char* file, AUDIOCOMMAND::PRIORITY priority, bool repeat = false);
+
+		// Read the replies and send the next byte of the current command.  Call from the loop.
+		void update();
+
+		// True while the board is playing a file started from the queue.
+		bool isPlaying();
+
+		// If a sound has started since the last call, "time" is set to when the board's answer arrived (milliseconds) and
+		// true is returned.  The repeating hum isn't reported.
+		bool getStart(unsigned long& time);
+
+		AUDIOCOMMAND::STATE getState();
+
+		// Number of files started, files the board didn't have, commands that weren't answered in time, and sounds dropped
+		// from the queue.
+		struct Counters
+		{
+			unsigned int									played;
+			unsigned int									missing;
+			unsigned int									timeouts;
+			unsigned int									dropped;
+		};
+
+		const Counters& getCounters();
+
+	private:
+		void startNextCommand();
+		void sendNextByte();
+		void finishCommand();
+
+		void readReplies();
+		void handleReply(char reply);
+
+	private:
+		struct Command
+		{
+			const char*										file;
+			AUDIOCOMMAND::PRIORITY							priority;
+			bool											repeat;
+		};
+
+		HAL::AudioSerial*									_serial;
+		unsigned int										_replyTimeout;
+		unsigned int										_byteDelay;
+
+		// Sounds waiting to be played, oldest first.  The first is the one being worked on unless the state is IDLE.
+		Command												_commands[nAudioCommands];
+		uint8_t												_numberOfCommands;
+
+		AUDIOCOMMAND::STATE									_state;
+
+		// Position in the command line being sent and when the last byte of it went out (the end of the line once it has
+		// all been sent).
+		uint8_t												_sendPosition;
+		unsigned long										_sentTime;
+
+		// The file the board is playing.
+		bool												_playing;
+		Command												_playingCommand;
+
+		// First character of the reply line being received (0 until one arrives).
+		char												_reply;
+
+		// The start of the latest sound, until it is picked up with getStart.
+		unsigned long										_startTime;
+		bool												_started;
+
+		Counters											_counters;
+};
+
+#endif
@@ -0,0 +1,139 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "BatteryMonitor.h"
+
+static_assert(batteryOversamplingBits <= 3, "The sum of the oversampled conversions has to fit in 16 bits.");
+
+BatteryMonitor* BatteryMonitor::_runningMonitor = nullptr;
+
+BatteryMonitor::BatteryMonitor(uint8_t pin, unsigned int minimumReading, unsigned int maximumReading, uint8_t lowCharge, uint8_t lowHysteresis) :
+	_pin(pin),
+	_minimumReading(minimumReading << batteryOversamplingBits),
+	_maximumReading(maximumReading << batteryOversamplingBits),
+	_lowCharge(lowCharge),
+	_lowHysteresis(lowHysteresis),
+	_sum(0),
+	_numberOfConversions(0),
+	_reading(0),
+	_newReading(false),
+	_filterSum(0),
+	_charge(0),
+	_low(false)
+{
+}
+
+BatteryMonitor::~BatteryMonitor()
+{
+}
+
+void BatteryMonitor::begin()
+{
+	// Start the filter from where the battery is now, not from empty.
+	unsigned long reading	= (unsigned long)HAL::analogRead(_pin) << batteryOversamplingBits;
+	_filterSum				= reading << batteryFilterShift;
+	updateCharge();
+
+	_runningMonitor = this;
+	HAL::startAnalogSampling(_pin, interruptHandler);
+}
+
+void BatteryMonitor::update()
+{
+	if (!_newReading)
+	{
+		return;
+	}
+
+	// The reading is two bytes, so the interrupt is held off while it is copied.
+	HAL::disableInterrupts();
+	uint16_t reading	= _reading;
+	_newReading			= false;
+	HAL::enableInterrupts();
+
+	_filterSum -= _filterSum >> batteryFilterShift;
+	_filterSum += reading;
+
+	updateCharge();
+}
+
+uint8_t BatteryMonitor::getCharge()
+{
+	return _charge;
+}
+
+uint8_t BatteryMonitor::getLevel()
+{
+	// 1 light up to 20%, 2 up to 40%, and so on.
+	uint8_t level = 1 + _charge / 20;
+	return level > 5 ? 5 : level;
+}
+
+bool BatteryMonitor::isLow()
+{
+	return _low;
+}
+
+unsigned int BatteryMonitor::getReading()
+{
+	return _filterSum >> batteryFilterShift;
+}
+
+void BatteryMonitor::interruptHandler(uint16_t value)
+{
+	BatteryMonitor* monitor = _runningMonitor;
+
+	monitor->_sum += value;
+	monitor->_numberOfConversions++;
+
+	// 4^n conversions summed and divided by 2^n gives n extra bits.
+	if (monitor->_numberOfConversions == 1 << (2*batteryOversamplingBits))
+	{
+		monitor->_reading				= monitor->_sum >> batteryOversamplingBits;
+		monitor->_newReading			= true;
+		monitor->_sum					= 0;
+		monitor->_numberOfConversions	= 0;
+	}
+}
+
+void BatteryMonitor::updateCharge()
+{
+	unsigned int reading = getReading();
+
+	if (reading <= _minimumReading)
+	{
+		_charge = 0;
+	}
+	else if (reading >= _maximumReading)
+	{
+		_charge = 100;
+	}
+	else
+	{
+		_charge = (unsigned long)(reading - _minimumReading) * 100 / (_maximumReading - _minimumReading);
+	}
+
+	if (_low)
+	{
+		_low = _charge < _lowCharge + _lowHysteresis;
+	}
+	else
+	{
+		_low = _charge < _lowCharge;
+	}
+}
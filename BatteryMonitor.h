@@ -0,0 +1,95 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef BATTERYMONITOR_H
+#define BATTERYMONITOR_H
+
+#include "HardwareAbstraction.h"
+
+// About how often (milliseconds) a new reading is ready.  The sample interrupt starts a conversion about once a millisecond.
+#define batteryReadingPeriod (1 << 2*batteryOversamplingBits)
+
+// Measures the battery without blocking.  The ADC converts the battery pin in the background (see
+// HAL::startAnalogSampling) and the conversion interrupt adds the results up.  Every 4^batteryOversamplingBits
+// conversions the sum is decimated into one reading with batteryOversamplingBits extra bits of resolution.  The loop
+// picks up the latest reading and runs it through a first order low pass (IIR) filter, so the charge estimate doesn't
+// jump around with the load of the lights.
+//
+// The filter keeps a running sum of 2^batteryFilterShift readings.  Each new reading is added and the running sum's
+// average taken off, which needs no multiplication or division.
+class BatteryMonitor
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		// The minimum and maximum readings (analogRead scale) are the empty and full battery.
+		BatteryMonitor(uint8_t pin, unsigned int minimumReading, unsigned int maximumReading, uint8_t lowCharge, uint8_t lowHysteresis);
+
+		// Default destructor.
+		~BatteryMonitor();
+
+	// Public interface.
+	public:
+		// Start sampling.  The filter is started from one (blocking) conversion, so the estimate is right from the start.
+		// Must be called after the sample interrupt is started.  Only one monitor can run at a time.
+		void begin();
+
+		// Filter the latest reading, if there is a new one.  Call from the loop.
+		void update();
+
+		// Charge estimate (percent).
+		uint8_t getCharge();
+
+		// Charge estimate as the number of blue lights to show (1 to 5).
+		uint8_t getLevel();
+
+		// True while the charge is low (with hysteresis, so it doesn't flicker at the boundary).
+		bool isLow();
+
+		// Filtered reading (analogRead scale, with batteryOversamplingBits extra bits).
+		unsigned int getReading();
+
+	private:
+		// Called from the conversion complete interrupt.
+		static void interruptHandler(uint16_t value);
+
+		void updateCharge();
+
+	private:
+		static BatteryMonitor*								_runningMonitor;
+
+		uint8_t												_pin;
+		unsigned int										_minimumReading;
+		unsigned int										_maximumReading;
+		uint8_t												_lowCharge;
+		uint8_t												_lowHysteresis;
+
+		// Written by the interrupt.
+		uint16_t											_sum;
+		uint8_t												_numberOfConversions;
+		volatile uint16_t									_reading;
+		volatile bool										_newReading;
+
+		// Running sum of the filter (2^batteryFilterShift times the filtered reading).
+		unsigned long										_filterSum;
+
+		uint8_t												_charge;
+		bool												_low;
+};
+
+#endif
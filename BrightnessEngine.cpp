@@ -0,0 +1,184 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "BrightnessEngine.h"
+
+#if useBrightnessEngine
+
+// The planes are timed by the timer interrupt (see HAL::startTimerInterrupt), which counts in steps of 16 microseconds up
+// to 4096 microseconds.  A plane that doesn't fit would wrap around and get the wrong weight.
+static_assert(brightnessTickTime % 16 == 0, "The brightness tick time must be a multiple of 16 microseconds.");
+static_assert((unsigned long)brightnessTickTime << (brightnessBits - 1) <= 4096, "The longest brightness plane (brightnessTickTime << (brightnessBits - 1)) must be no more than 4096 microseconds.");
+
+BrightnessStatistics::BrightnessStatistics() :
+	_numberOfRefreshes(0),
+	_totalRefreshTime(0),
+	_maximumRefreshTime(0),
+	_refreshTime(0)
+{
+}
+
+BrightnessStatistics::~BrightnessStatistics()
+{
+}
+
+unsigned long BrightnessStatistics::getNumberOfRefreshes()
+{
+	HAL::disableInterrupts();
+	unsigned long value = _numberOfRefreshes;
+	HAL::enableInterrupts();
+	return value;
+}
+
+unsigned long BrightnessStatistics::getTotalRefreshTime()
+{
+	HAL::disableInterrupts();
+	unsigned long value = _totalRefreshTime;
+	HAL::enableInterrupts();
+	return value;
+}
+
+unsigned int BrightnessStatistics::getMaximumRefreshTime()
+{
+	HAL::disableInterrupts();
+	unsigned int value = _maximumRefreshTime;
+	HAL::enableInterrupts();
+	return value;
+}
+
+void BrightnessStatistics::resetStatistics()
+{
+	HAL::disableInterrupts();
+	_numberOfRefreshes	= 0;
+	_totalRefreshTime	= 0;
+	_maximumRefreshTime	= 0;
+	HAL::enableInterrupts();
+}
+
+void BrightnessStatistics::addPlaneTime(unsigned long time, bool lastPlane)
+{
+	_refreshTime += time;
+
+	if (lastPlane)
+	{
+		_numberOfRefreshes++;
+		_totalRefreshTime += _refreshTime;
+		if (_refreshTime > _maximumRefreshTime)
+		{
+			_maximumRefreshTime = _refreshTime;
+		}
+		_refreshTime = 0;
+	}
+}
+
+template<typename Profile>
+BrightnessEngine<Profile>* BrightnessEngine<Profile>::_runningEngine = nullptr;
+
+template<typename Profile>
+BrightnessEngine<Profile>::BrightnessEngine(HAL::ShiftRegister<Profile::numberOfShiftRegisters>* shiftRegister) :
+	_shiftRegister(shiftRegister),
+	_frontBuffer(0),
+	_newPlanes(false),
+	_currentPlane(0)
+{
+	for (int buffer = 0; buffer < 2; buffer++)
+	{
+		for (int plane = 0; plane < brightnessBits; plane++)
+		{
+			for (int i = 0; i < Profile::numberOfShiftRegisters; i++)
+			{
+				_planes[buffer][plane][i] = 0;
+			}
+		}
+	}
+}
+
+template<typename Profile>
+BrightnessEngine<Profile>::~BrightnessEngine()
+{
+}
+
+template<typename Profile>
+void BrightnessEngine<Profile>::begin()
+{
+	_runningEngine = this;
+	HAL::startTimerInterrupt(interruptHandler, brightnessTickTime);
+}
+
+template<typename Profile>
+void BrightnessEngine<Profile>::setPlanes(const uint8_t planes[brightnessBits][Profile::numberOfShiftRegisters])
+{
+	// The interrupt only swaps buffers at the start of a refresh, but it must not swap while the back buffer is being
+	// written.  The copy is short (a few microseconds), so the interrupt is held off for it.
+	HAL::disableInterrupts();
+
+	uint8_t backBuffer = 1 - _frontBuffer;
+	for (int plane = 0; plane < brightnessBits; plane++)
+	{
+		for (int i = 0; i < Profile::numberOfShiftRegisters; i++)
+		{
+			_planes[backBuffer][plane][i] = planes[plane][i];
+		}
+	}
+	_newPlanes = true;
+
+	HAL::enableInterrupts();
+}
+
+template<typename Profile>
+void BrightnessEngine<Profile>::interruptHandler()
+{
+	_runningEngine->showNextPlane();
+}
+
+template<typename Profile>
+void BrightnessEngine<Profile>::showNextPlane()
+{
+	unsigned long start = HAL::micros();
+
+	// Start of a refresh.  Pick up new planes if there are any.
+	if (_currentPlane == 0 && _newPlanes)
+	{
+		_frontBuffer	= 1 - _frontBuffer;
+		_newPlanes		= false;
+	}
+
+	_shiftRegister->setAll(_planes[_frontBuffer][_currentPlane]);
+
+	// The plane stays on until the next interrupt, which is set by the weight of the plane's bit.
+	HAL::setTimerInterruptPeriod(brightnessTickTime << _currentPlane);
+
+	_currentPlane++;
+	if (_currentPlane == brightnessBits)
+	{
+		_currentPlane = 0;
+	}
+
+	addPlaneTime(HAL::micros() - start, _currentPlane == 0);
+}
+
+// The profile that is built.  The simulator builds every profile, so a change that breaks one shows up whichever is
+// selected.  A new profile is added to its list.
+#if defined(ARDUINO)
+	template class BrightnessEngine<Configuration>;
+#else
+	template class BrightnessEngine<StandardProfile>;
+	template class BrightnessEngine<LowPowerProfile>;
+#endif
+
+#endif
@@ -0,0 +1,98 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef BRIGHTNESSENGINE_H
+#define BRIGHTNESSENGINE_H
+
+#include "HardwareAbstraction.h"
+#include "Configuration.h"
+
+// The refresh statistics of a brightness engine, used to measure the processor time the engine takes.  Times are
+// microseconds.  They don't depend on the profile, so the loop statistics report the engine through this.
+class BrightnessStatistics
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		BrightnessStatistics();
+
+		// Default destructor.
+		~BrightnessStatistics();
+
+	// Public interface.
+	public:
+		unsigned long getNumberOfRefreshes();
+		unsigned long getTotalRefreshTime();
+		unsigned int getMaximumRefreshTime();
+		void resetStatistics();
+
+	protected:
+		// Called by the interrupt with the time it took to show a plane.  The times are added up over a complete refresh.
+		void addPlaneTime(unsigned long time, bool lastPlane);
+
+	private:
+		// A refresh is one complete cycle through the planes.
+		volatile unsigned long								_numberOfRefreshes;
+		volatile unsigned long								_totalRefreshTime;
+		volatile unsigned int								_maximumRefreshTime;
+		unsigned long										_refreshTime;
+};
+
+// Dims the shift register outputs with binary code modulation.  The brightness of every output is split into bit
+// planes.  A timer interrupt shifts out one plane at a time and keeps it on the outputs for a time proportional to the
+// weight of its bit (1, 2, 4, ... ticks).  Only one frame is shifted out per bit, so a refresh costs "brightnessBits"
+// frames no matter how many outputs there are.
+//
+// The planes are double buffered.  New planes are handed over with setPlanes and are picked up by the interrupt at the
+// start of the next refresh, so a refresh never mixes old and new planes.
+template<typename Profile>
+class BrightnessEngine : public BrightnessStatistics
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		BrightnessEngine(HAL::ShiftRegister<Profile::numberOfShiftRegisters>* shiftRegister);
+
+		// Default destructor.
+		~BrightnessEngine();
+
+	// Public interface.
+	public:
+		// Start refreshing the outputs.  Only one engine can run at a time.
+		void begin();
+
+		// Copy in a new set of bit planes.  Plane 0 is the least significant bit.
+		void setPlanes(const uint8_t planes[brightnessBits][Profile::numberOfShiftRegisters]);
+
+	private:
+		// Called by the timer interrupt to show the next plane.
+		static void interruptHandler();
+		void showNextPlane();
+
+	private:
+		static BrightnessEngine*							_runningEngine;
+
+		HAL::ShiftRegister<Profile::numberOfShiftRegisters>*	_shiftRegister;
+
+		uint8_t												_planes[2][brightnessBits][Profile::numberOfShiftRegisters];
+		volatile uint8_t									_frontBuffer;
+		volatile bool										_newPlanes;
+		uint8_t												_currentPlane;
+};
+
+#endif
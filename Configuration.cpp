@@ -0,0 +1,25 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "HardwareAbstraction.h"
+#include "Configuration.h"
+
+// Arrays have to be defined outside the class to be indexed at run time (C++11).  The values are in the header.  A
+// variant that redefines one needs a definition here as well.
+constexpr int StandardSettings::stateInputPins[GENERATOR::NUMBEROFSTATES];
+constexpr uint8_t StandardSettings::outputs[AUDIO::NUMBEROFOUTPUTS];
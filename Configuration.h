@@ -20,36 +20,171 @@
 
 #include "enums.h"
 
-// Number of shift registers used.
-#define nShiftRegisters 2
+// How the shift registers are driven.
+//	SHIFTREGISTERBITBANG	The bits are shifted out in software.  Works on any pins (shiftRegisterDataPin and
+//							shiftRegisterClockPin below).  A frame takes roughly 100+ microseconds.
+//	SHIFTREGISTERSPI		The hardware SPI peripheral shifts the bits out.  A frame takes a few microseconds.  The data
+//							and clock lines must be wired to the SPI pins (11 and 13 on the Uno), which means the audio
+//							transmit pin has to move off of 13.  Pin 12 (MISO) can't be used as the latch pin because the
+//							SPI peripheral makes it an input.
+#define SHIFTREGISTERBITBANG		0
+#define SHIFTREGISTERSPI			1
+#define shiftRegisterBackend		SHIFTREGISTERBITBANG
 
-struct Configuration
-{
-	// DEBUGGING.
-	// If true (1) debugging messages are printed.
-	const DEBUG::DEBUGLEVEL		DebugLevel									= DEBUG::STANDARD;
+// Brightness control of the shift register outputs.  When turned on (1), a timer interrupt (Timer2 on the AVR) refreshes
+// the shift registers using binary code modulation so every light can be dimmed.  Each refresh shifts out a full frame, so
+// use the SPI backend.  Bit banging takes longer than the shortest refresh period.  When turned off (0), the engine is
+// compiled out and the lights are only on or off.
+#define useBrightnessEngine			0
+
+// Number of brightness bits (4 to 6).  More bits give smoother fades but a lower refresh rate.
+#define brightnessBits				4
+
+// Time the least significant brightness bit is shown (microseconds, a multiple of 16).  A complete refresh of the lights
+// takes (2^brightnessBits - 1) times this.  The most significant bit is shown for 2^(brightnessBits - 1) times this,
+// which must be no more than 4096 microseconds (the longest the timer counts).
+#define brightnessTickTime			64
+
+// Debugging messages at or below this level are compiled in.  Messages above it are removed by the compiler, strings
+// included.  With DEBUGOFF the serial port is not used at all, and the trace, loop statistics, and memory report below
+// are left out too, so that is all a release build needs.  The levels are the same as DEBUG::OFF, DEBUG::STANDARD, and
+// DEBUG::VERBOSE, but can also be tested by the preprocessor.
+#define DEBUGOFF					0
+#define DEBUGSTANDARD				1
+#define DEBUGVERBOSE				2
+#define debugLevel					DEBUGSTANDARD
+
+// Size (bytes) of the buffer debugging messages wait in to be sent.  Must be a power of 2 and no more than 256.  If a
+// message doesn't fit, it is dropped rather than waiting for room.
+#define nLogBufferBytes				128
+
+// Binary trace of timing events (state changes, blue light steps, audio triggers).  When turned on (1), the events are
+// recorded into a small buffer in RAM and sent out as text when a "t" is received on the debug serial port.  Use the
+// NaquadahTrace tool in the Simulator folder to decode it.  On whenever debugging (debugLevel) is, set it to 0 to leave
+// it out of a debugging build.
+#define useTrace					(debugLevel > DEBUGOFF)
+
+// Number of events the trace keeps (4 bytes each, no more than 250).  When it is full, the oldest events are overwritten.
+#define nTraceEvents				32
+
+// Loop timing counters (update times, blue light step lateness, shift register latches).  When turned on (1), the
+// counters are kept and sent out when an "l" is received on the debug serial port ("c" clears them).  On whenever
+// debugging (debugLevel) is, so they are removed completely from release builds.  Set it to 0 to leave them out of a
+// debugging build.
+#define useLoopStatistics			(debugLevel > DEBUGOFF)
+
+// Memory report.  When turned on (1), the RAM and flash data used by each part of the generator, and the free RAM left
+// for the stack, are sent out when an "m" is received on the debug serial port.  On whenever debugging (debugLevel) is,
+// set it to 0 to leave it out of a debugging build.
+#define useMemoryReport				(debugLevel > DEBUGOFF)
+
+// RAM (bytes) kept free for the stack and the interrupts.  The build fails if the static data doesn't leave this much.
+#define nStackReserveBytes			384
+
+// Battery voltage sampling.  The ADC converts the battery pin in the background, started by the hardware about once a
+// millisecond, so the loop never waits for a conversion.  Each reading is the average of 4^batteryOversamplingBits
+// conversions, which adds that many bits of resolution.  The readings are smoothed by a filter that moves
+// 1/2^batteryFilterShift of the way to each new one.
+#define batteryOversamplingBits		2
+#define batteryFilterShift			4
 
+// Idle sleep.  When turned on (1), the processor sleeps at the end of every pass through the loop until the next
+// interrupt.  Everything the loop waits for is timed with millis (which only moves in the Timer0 interrupt) or seen by
+// the sample interrupt, so nothing comes due while it sleeps and the loop still runs at least once a millisecond.  Only
+// the idle sleep mode keeps the timers, the ADC, and the serial ports running, so that is the one used.
+#define useIdleSleep				1
+
+// How sounds are started on the audio board.  When turned on (1), the board is started in UART mode (the UG line held
+// low) and files are played by name over the audio serial port (see AudioQueue).  The commands go out a byte per pass
+// through the loop and the replies are read as they arrive, so the loop never waits on the board.  When turned off (0),
+// the board is started in trigger mode and sounds are started by pulsing its trigger lines on the shift register.
+// Trigger mode is the default, it works with the files already on the board and adds the least latency.
+//
+// The audio serial port is a SoftwareSerial port, which turns interrupts off while it sends or receives a byte: about a
+// millisecond per byte at 9600 baud.  That is about 13 milliseconds for a play command and 20 for the board's answer.
+// Meanwhile millis can lose a tick, input samples come late, and, with the brightness engine, a brightness plane is
+// shown too long, which shows up as a flicker.  While the engine runs, the commands are sent more slowly to spread the
+// flicker out (see audioSerialByteDelay), at the cost of starting sounds later.  The replies can't be slowed down.
+// UART mode needs these files on the board instead:
+//	NQHGENON.OGG	The hum, looped in the ON state.
+//	STATECHG.OGG	Played when the arm changes position.
+//	OVERLOAD.OGG	Played at full overload.
+#define useAudioSerial				0
+
+// Overload sound trigger line.  When turned on (1), reaching full overload in trigger mode pulses a trigger line of its
+// own, wired from shift register output 15 (after the state change trigger) to a free trigger input of the audio board,
+// which needs a file for it.  When turned off (0), the default, output 15 isn't used and the state change trigger is
+// pulsed instead, so the existing wiring and files work.  Over the serial port, OVERLOAD.OGG is played either way.
+#define useOverloadTrigger			0
+
+// PROFILES.
+// The settings of the standard prop are in StandardSettings.  A variant of the prop derives its settings from them and
+// only redefines the ones that are different (LowPowerSettings, for example).  A profile is a set of settings with the
+// settings computed from them added by DerivedProfile, so a variant never has to repeat those.  The generator is a
+// template on its profile, and the profile that is built is the one Configuration stands for (at the bottom of the file).
+// Everything in a profile is a constant, so the values are built right into the code.
+struct StandardSettings
+{
 	// INPUT.
-	// Just set the input pins the 4 hall effect sensors is on.  The number of state pins
-	// should not be changed.
-	int	const					stateInputPins[GENERATOR::NUMBEROFSTATES]	= {A5, A4, A3, A2};
+	// Hall effect sensor pins (one per generator state) and button pins.  They are template arguments of the fast pins
+	// (see FastPins.h), so they are read directly through the port registers.  Keep the 4 sensors on one port (A0 to A5
+	// on the Uno/Nano) so they can all be read at once.  Otherwise they are read one at a time.  The sensors and buttons
+	// are debounced together (see InputCapture).
+	static constexpr int				stateInputPins[GENERATOR::NUMBEROFSTATES]	= {A5, A4, A3, A2};
 
 	// The pin the mode button is connected to.
-	const int					modeButtonPin								=  9;
+	static constexpr int				modeButtonPin								= 9;
+
+	// OUTPUTS.
+	// Number of shift registers chained for the lights and the audio trigger lines.
+	static constexpr uint8_t			numberOfShiftRegisters						= 2;
+
+	// The output map.  The shift register output (bit n of the chain, starting with the first output of the register
+	// closest to the board) each light and audio line is wired to, in LIGHT::SHIFTREGISTER and then AUDIO::SHIFTREGISTER
+	// order.  The lights must be on the first 16 outputs, and the blue lights on consecutive outputs, in order.
+	static constexpr uint8_t			outputs[AUDIO::NUMBEROFOUTPUTS]				=
+	{
+		//	RED		BLUE1	BLUE2	BLUE3	BLUE4	BLUE5	WHITE	GREEN	READY
+			0,		1,		2,		3,		4,		5,		6,		7,		8,
+		//	RESET	LATCH	ON		RANDOM	UG		STATECHANGE		OVERLOAD
+			9,		10,		11,		12,		13,		14,				15
+	};
 
 	// LIGHTS.
 	// Output shift register pins.
-	const int					shiftRegisterDataPin						=  4;
-	const int					shiftRegisterClockPin						=  6;
-	const int					shiftRegisterLatchPin						= 12;
+	static constexpr int				shiftRegisterDataPin						=  4;
+	static constexpr int				shiftRegisterClockPin						=  6;
+	static constexpr int				shiftRegisterLatchPin						= 12;
 	
 	 // Green indicator light to indicate Arduino is ready.
-	const int					readyIndicatorPin          					=  8;
+	static constexpr int				readyIndicatorPin							= 8;
 
 	// AUDIO.
-	const int					rxFromAudioTxPin							=  5;
-	const int					txToAudioRxPin								= 13;
-	const int					audioResetPin								= 10;
+	static constexpr int				rxFromAudioTxPin							=  5;
+	static constexpr int				txToAudioRxPin								= 13;
+	static constexpr int				audioResetPin								= 10;
+
+	// How long (milliseconds) the audio trigger lines on the shift register are held active.
+	static constexpr unsigned int		audioTriggerDuration						= 120;
+
+	// The trigger line pulsed for the overload sound (see useOverloadTrigger).
+	static constexpr uint8_t			overloadAudioTrigger						= useOverloadTrigger ? AUDIO::OVERLOAD : AUDIO::STATECHANGE;
+
+	// How long (milliseconds) to wait for the audio board to answer a command sent over the serial port.
+	static constexpr unsigned int		audioReplyTimeout							= 250;
+
+	// Least time (milliseconds) between the bytes of a command sent over the serial port.  Each byte turns interrupts off
+	// for about a millisecond (see useAudioSerial), so with the brightness engine they are spread out.  A play command is
+	// 13 bytes, so this adds about 12 times this to the start of a sound.
+	static constexpr unsigned int		audioSerialByteDelay						= useBrightnessEngine ? 8 : 0;
+
+	// Time (milliseconds) from an audio trigger going active, or the audio board answering a play command, until the
+	// sound is heard.  In trigger mode the board still has to open the file.  Over the serial port it answers once the
+	// file is playing.  Light cues synchronized to a sound (see "sync" in LightSequences.txt) are timed from then.
+	static constexpr unsigned int		audioStartLatency							= useAudioSerial ? 0 : 20;
+
+	// How long (milliseconds) a light sequence waits for its sound to start before carrying on without it.
+	static constexpr unsigned int		audioSyncTimeout							= 500;
 
 
 	// CHARGER/BOOSTER ACTIVATION
@@ -64,23 +199,107 @@ struct Configuration
 
 	// BATTERY METER SETTINGS.
 	// The pin the activation button is on.
-	unsigned int				batteryMeterActivationPin					= 7;
+	static constexpr unsigned int		batteryMeterActivationPin					= 7;
 
 	// The pin that is used to sense the battery voltage.
-	unsigned int				batteryMeterSensePin						= A1;
+	static constexpr unsigned int		batteryMeterSensePin						= A1;
 	
 	// Set the min and max reading values that correspond to 2.7 and 4.2 volts (for a lithium battery).
-	unsigned int				batteryMinReading							= 646;
-	unsigned int				batteryMaxReading							= 865;
+	static constexpr unsigned int		batteryMinReading							= 646;
+	static constexpr unsigned int		batteryMaxReading							= 865;
+
+	// How often (milliseconds) the battery level lights are updated.  Prevents flickering when the reading is near the
+	// boundary between two levels.
+	static constexpr unsigned int		batteryMeterUpdateDelay						= 1000;
+
+	// Charge (percent) below which the ready indicator blinks to warn of a low battery.  The warning is given in every
+	// state and stops once the charge is back above it by the hysteresis.
+	static constexpr uint8_t			batteryLowCharge							= 10;
+	static constexpr uint8_t			batteryLowHysteresis						= 5;
+
+	// How often (milliseconds) the ready indicator changes while warning of a low battery.
+	static constexpr unsigned int		batteryWarningBlinkDelay					= 500;
 
 	// BEHAVIOR SETTINGS.
 	// Values for timing.
-	const unsigned int			blueLightStandardDelay						= 130;
-	const unsigned int			blueLightOverloadIncrement					= 16;
-	const unsigned int			startUpDelay								= 1.5*blueLightStandardDelay;
+	static constexpr unsigned int		blueLightStandardDelay						= 130;
+	static constexpr unsigned int		blueLightOverloadIncrement					= 16;
+
+	// Overload.  When the mode button changes the overload level in the ON state, the blue light scroll speed is eased to
+	// the new rate over a number of blue light steps, following the curve.  Full overload is the critical phase, which
+	// plays the overload sound and flashes the white light with it.
+	static constexpr OVERLOAD::CURVE	overloadCurve								= OVERLOAD::EASEIN;
+	static constexpr uint8_t			overloadRampSteps							= 8;
 
 	// Start up sequence.
-	const bool					runStartUpSequence							= true;
+	static constexpr bool				runStartUpSequence							= true;
+
+	// Brightness cap for all the lights (0 to 2^brightnessBits - 1).  Used to limit the total current drawn.  Only the
+	// brightness engine can dim the lights, without it they are always at full brightness (see maximumBrightness).
+	static constexpr uint8_t			brightnessLimit								= (1 << brightnessBits) - 1;
+};
+
+// The standard prop run from a smaller battery.  The lights scroll slower and the low battery warning comes on earlier.
+// With the brightness engine turned on, the lights are dimmer as well.
+struct LowPowerSettings : StandardSettings
+{
+	static constexpr uint8_t			batteryLowCharge							= 20;
+	static constexpr unsigned int		blueLightStandardDelay						= 160;
+	static constexpr uint8_t			brightnessLimit								= (1 << brightnessBits) / 2;
+};
+
+// Checks of the output map of a set of settings.
+namespace OUTPUTMAP
+{
+	// True if the outputs in the map from "first" up to (but not including) "end" are all below "limit".
+	template<typename Settings> constexpr bool isBelow(uint8_t first, uint8_t end, uint8_t limit)
+	{
+		return first == end || (Settings::outputs[first] < limit && isBelow<Settings>(first + 1, end, limit));
+	}
+
+	// True if each blue light from "light" on is on the output after the one before it.
+	template<typename Settings> constexpr bool isConsecutive(uint8_t light)
+	{
+		return light > LIGHT::BLUE5 || (Settings::outputs[light] == Settings::outputs[light - 1] + 1 && isConsecutive<Settings>(light + 1));
+	}
+}
+
+// A profile: a set of settings and the settings computed from them.
+template<typename Settings>
+struct DerivedProfile : Settings
+{
+	static_assert(OUTPUTMAP::isBelow<Settings>(0, AUDIO::NUMBEROFOUTPUTS, 8*Settings::numberOfShiftRegisters), "An output in the output map is beyond the last shift register.");
+	static_assert(OUTPUTMAP::isBelow<Settings>(LIGHT::RED, LIGHT::READY, 16), "The lights (other than the ready light) must be on the first 16 outputs, the masked writes only reach those.");
+	static_assert(OUTPUTMAP::isConsecutive<Settings>(LIGHT::BLUE2), "The blue lights must be on consecutive outputs, in order.");
+
+	// Time (milliseconds) of a beat of the start up sequence and the other light sequences.
+	static constexpr unsigned int		startUpDelay								= 1.5*Settings::blueLightStandardDelay;
+
+	// Brightness cap the lights are held to.  The brightness limit when the brightness engine is turned on, full
+	// brightness otherwise.
+	static constexpr uint8_t			maximumBrightness							= useBrightnessEngine ? Settings::brightnessLimit : (1 << brightnessBits) - 1;
+
+	// Number of outputs on the shift registers.
+	static constexpr uint8_t			numberOfOutputs								= 8*Settings::numberOfShiftRegisters;
+
+	// Masks of the lights on the shift register outputs (see OutputFrame::setMasked).  The blue light patterns (see
+	// LightPatterns.h) start at the first blue light, they are shifted by its output.
+	static constexpr uint8_t			firstBlueLightOutput						= Settings::outputs[LIGHT::BLUE1];
+	static constexpr LIGHT::MASK		blueLightMask								= (LIGHT::maskOf(LIGHT::NUMBEROFBLUELIGHTS) - 1) << firstBlueLightOutput;
+	static constexpr LIGHT::MASK		allLightsMask								= LIGHT::maskOf(Settings::outputs[LIGHT::RED]) | blueLightMask | LIGHT::maskOf(Settings::outputs[LIGHT::WHITE]) | LIGHT::maskOf(Settings::outputs[LIGHT::GREEN]);
 };
 
+template<typename Settings> constexpr unsigned int	DerivedProfile<Settings>::startUpDelay;
+template<typename Settings> constexpr uint8_t		DerivedProfile<Settings>::maximumBrightness;
+template<typename Settings> constexpr uint8_t		DerivedProfile<Settings>::numberOfOutputs;
+template<typename Settings> constexpr uint8_t		DerivedProfile<Settings>::firstBlueLightOutput;
+template<typename Settings> constexpr LIGHT::MASK	DerivedProfile<Settings>::blueLightMask;
+template<typename Settings> constexpr LIGHT::MASK	DerivedProfile<Settings>::allLightsMask;
+
+typedef DerivedProfile<StandardSettings>	StandardProfile;
+typedef DerivedProfile<LowPowerSettings>	LowPowerProfile;
+
+// The profile that is built.
+typedef StandardProfile						Configuration;
+
 #endif
\ No newline at end of file
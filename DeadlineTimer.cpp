@@ -0,0 +1,83 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#include "DeadlineTimer.h"
+
+DeadlineTimer::DeadlineTimer() :
+	_lastDeadline(0),
+	_period(0),
+	_lateness(0)
+{
+}
+
+DeadlineTimer::~DeadlineTimer()
+{
+}
+
+void DeadlineTimer::start(unsigned int period)
+{
+	_lastDeadline	= HAL::millis();
+	_period			= period;
+	_lateness		= 0;
+}
+
+void DeadlineTimer::setPeriod(unsigned int period)
+{
+	_period = period;
+}
+
+uint8_t DeadlineTimer::update()
+{
+	unsigned long now		= HAL::millis();
+	unsigned long deadline	= _lastDeadline + _period;
+
+	// The signed difference keeps working when millis rolls over.
+	if ((long)(now - deadline) < 0 || _period == 0)
+	{
+		return 0;
+	}
+
+	unsigned long late	= now - deadline;
+	_lateness			= late > 0xFFFF ? 0xFFFF : late;
+
+	// Usually the deadline was just passed.  Only a stalled loop needs the (slow on the AVR) division.
+	unsigned long passed = 1;
+	if (late >= _period)
+	{
+		passed = 1 + late / _period;
+	}
+
+	if (passed > 255)
+	{
+		// Stalled for so long that staying in phase doesn't matter.  Start over from now.
+		_lastDeadline = now;
+		return 255;
+	}
+
+	_lastDeadline = deadline + (passed - 1) * _period;
+	return passed;
+}
+
+unsigned int DeadlineTimer::getLateness()
+{
+	return _lateness;
+}
+
+unsigned long DeadlineTimer::getDeadline()
+{
+	return _lastDeadline + _period;
+}
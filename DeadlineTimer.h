@@ -0,0 +1,63 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#ifndef DEADLINETIMER_H
+#define DEADLINETIMER_H
+
+#include "HardwareAbstraction.h"
+
+// A periodic timer that keeps absolute deadlines.  Each deadline is the previous one plus the period, not the time the
+// previous one was noticed plus the period, so being late to one deadline doesn't push the later ones back and the
+// average rate is exactly one per period.
+//
+// If the loop stalls for a whole period or more, the missed deadlines are skipped, not caught up one after the other.
+// update reports how many deadlines were passed, so the caller can move ahead by that many steps at once and stay in
+// phase, and the timer carries on from the most recent deadline that was passed.
+class DeadlineTimer
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		DeadlineTimer();
+
+		// Default destructor.
+		~DeadlineTimer();
+
+	// Public interface.
+	public:
+		// Start with the first deadline one period (milliseconds) from now.
+		void start(unsigned int period);
+
+		// Change the period.  The next deadline is moved to one (new) period after the last deadline.
+		void setPeriod(unsigned int period);
+
+		// Returns the number of deadlines that have passed since the last call (0 if none).  Call from the loop.
+		uint8_t update();
+
+		// How late (milliseconds) the first of the deadlines passed in the last update was handled.
+		unsigned int getLateness();
+
+		// The next deadline (milliseconds, same clock as millis).
+		unsigned long getDeadline();
+
+	private:
+		unsigned long										_lastDeadline;
+		unsigned int										_period;
+		unsigned int										_lateness;
+};
+
+#endif
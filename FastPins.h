@@ -0,0 +1,167 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#ifndef FASTPINS_H
+#define FASTPINS_H
+
+#include "HardwareAbstraction.h"
+
+// Direct port register access for pins that are known at compile time.  digitalRead and digitalWrite look the pin up in
+// tables in flash on every call (about 3 to 4 microseconds each).  When the pin numbers are template arguments, the
+// compiler works out the port and bit, so a write becomes a single sbi/cbi instruction and a group of inputs on the same
+// port is read with a single "in" instruction.
+//
+// The mapping is the ATmega328P/168 one (Uno, Nano, Pro Mini).  On other boards, in the simulator, or if the pins of an
+// input group are not all on one port, the portable digitalRead/digitalWrite path is used instead.  Output pins should
+// not be PWM pins with analogWrite in use (digitalWrite turns the PWM off, a direct write does not).
+#if defined(ARDUINO) && (defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__))
+	#define fastPinsAvailable 1
+#else
+	#define fastPinsAvailable 0
+#endif
+
+namespace HAL
+{
+	namespace FASTPIN
+	{
+		// Ports, in Arduino pin order.  Pins 0 to 7 are port D, 8 to 13 port B, and 14 to 19 (A0 to A5) port C.
+		enum PORT : uint8_t
+		{
+			D,
+			B,
+			C
+		};
+
+		constexpr PORT port(uint8_t pin)
+		{
+			return pin < 8 ? D : (pin < 14 ? B : C);
+		}
+
+		constexpr uint8_t mask(uint8_t pin)
+		{
+			return 1 << (pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14));
+		}
+
+		// True when all the pins are on one port.
+		constexpr bool onePort(uint8_t)
+		{
+			return true;
+		}
+
+		template<typename... Pins> constexpr bool onePort(uint8_t first, uint8_t second, Pins... rest)
+		{
+			return port(first) == port(second) && onePort(second, rest...);
+		}
+
+		template<typename... Pins> constexpr uint8_t firstPin(uint8_t first, Pins...)
+		{
+			return first;
+		}
+
+		// Moves the bit of each pin in a port reading to the position of the pin in the list (the first pin becomes
+		// bit 0, and so on).
+		constexpr uint8_t gather(uint8_t, uint8_t)
+		{
+			return 0;
+		}
+
+		template<typename... Pins> constexpr uint8_t gather(uint8_t value, uint8_t index, uint8_t first, Pins... rest)
+		{
+			return ((value & mask(first)) ? (1 << index) : 0) | gather(value, index + 1, rest...);
+		}
+
+		#if fastPinsAvailable
+			// The port must be a constant for these to compile down to single instructions.
+			inline volatile uint8_t& inputRegister(PORT port)
+			{
+				return port == D ? PIND : (port == B ? PINB : PINC);
+			}
+
+			inline volatile uint8_t& outputRegister(PORT port)
+			{
+				return port == D ? PORTD : (port == B ? PORTB : PORTC);
+			}
+		#endif
+	}
+
+	// An output pin.
+	template<uint8_t pin> class FastOutputPin
+	{
+		public:
+			static void begin()
+			{
+				HAL::pinMode(pin, OUTPUT);
+			}
+
+			static void write(uint8_t value)
+			{
+				#if fastPinsAvailable
+					if (value == LOW)
+					{
+						FASTPIN::outputRegister(FASTPIN::port(pin)) &= ~FASTPIN::mask(pin);
+					}
+					else
+					{
+						FASTPIN::outputRegister(FASTPIN::port(pin)) |= FASTPIN::mask(pin);
+					}
+				#else
+					HAL::digitalWrite(pin, value);
+				#endif
+			}
+	};
+
+	// A group of up to 8 active low inputs (pulled up, active when pulled to ground).
+	template<uint8_t... pins> class FastInputPins
+	{
+		public:
+			static const uint8_t numberOfPins = sizeof...(pins);
+
+			static void begin()
+			{
+				const uint8_t pinList[] = {pins...};
+				for (uint8_t i = 0; i < numberOfPins; i++)
+				{
+					HAL::pinMode(pinList[i], INPUT_PULLUP);
+				}
+			}
+
+			// Bit "i" of the result is set when the "i"th pin is active.
+			static uint8_t readActive()
+			{
+				#if fastPinsAvailable
+					if (FASTPIN::onePort(pins...))
+					{
+						uint8_t value = ~FASTPIN::inputRegister(FASTPIN::port(FASTPIN::firstPin(pins...)));
+						return FASTPIN::gather(value, 0, pins...);
+					}
+				#endif
+
+				const uint8_t pinList[] = {pins...};
+				uint8_t active = 0;
+				for (uint8_t i = 0; i < numberOfPins; i++)
+				{
+					if (HAL::digitalRead(pinList[i]) == LOW)
+					{
+						active |= 1 << i;
+					}
+				}
+				return active;
+			}
+	};
+}
+
+#endif
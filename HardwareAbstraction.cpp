@@ -0,0 +1,278 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "HardwareAbstraction.h"
+
+#if defined(ARDUINO) && defined(__AVR__)
+
+#include <avr/sleep.h>
+
+// The end of the static data and of the heap, set by the linker and malloc.
+extern uint8_t	__heap_start;
+extern uint8_t*	__brkval;
+
+namespace
+{
+	void (*sampleInterruptHandler)() = nullptr;
+	void (*analogSampleHandler)(uint16_t value) = nullptr;
+
+	// Fill for the free RAM.  Anything else there has been written by the stack (or an interrupt on it).
+	const uint8_t stackPaint = 0xC5;
+
+	inline uint8_t* getHeapEnd()
+	{
+		return __brkval != nullptr ? __brkval : &__heap_start;
+	}
+}
+
+void HAL::startSampleInterrupt(void (*handler)())
+{
+	sampleInterruptHandler = handler;
+
+	// Timer0 overflows every 1024 microseconds for millis.  Its compare A interrupt fires once per overflow as well, at
+	// the point set here (half way through), so it doesn't land on top of the millis interrupt.
+	noInterrupts();
+	OCR0A	= 0x80;
+	TIMSK0 |= _BV(OCIE0A);
+	interrupts();
+}
+
+ISR(TIMER0_COMPA_vect)
+{
+	sampleInterruptHandler();
+}
+
+void HAL::startAnalogSampling(uint8_t pin, void (*handler)(uint16_t value))
+{
+	analogSampleHandler = handler;
+
+	// Same channel numbering as analogRead.
+	uint8_t channel = pin >= A0 ? pin - A0 : pin;
+
+	// The AVcc reference (as analogRead uses), auto triggered by the Timer0 compare A match of the sample interrupt.
+	// The interrupt clears the compare flag, so there is a new trigger every 1024 microseconds.  A prescaler of 128
+	// gives the 125 kHz ADC clock a 10 bit conversion needs.  A conversion takes 104 microseconds.
+	noInterrupts();
+	ADMUX	= _BV(REFS0) | (channel & 0x07);
+	ADCSRB	= _BV(ADTS1) | _BV(ADTS0);
+	ADCSRA	= _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+	interrupts();
+}
+
+ISR(ADC_vect)
+{
+	analogSampleHandler(ADC);
+}
+
+void HAL::sleep()
+{
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	sleep_cpu();
+	sleep_disable();
+}
+
+void HAL::paintStack()
+{
+	// Stop short of the stack pointer, this function's own frame is just above it.
+	uint8_t* end = (uint8_t*)SP - 16;
+	for (uint8_t* address = getHeapEnd(); address < end; address++)
+	{
+		*address = stackPaint;
+	}
+}
+
+unsigned int HAL::getFreeMemory()
+{
+	return (uint8_t*)SP - getHeapEnd();
+}
+
+unsigned int HAL::getLeastFreeMemory()
+{
+	uint8_t*		address	= getHeapEnd();
+	unsigned int	count	= 0;
+	while (address < (uint8_t*)SP && *address == stackPaint)
+	{
+		address++;
+		count++;
+	}
+	return count;
+}
+
+#endif
+
+// The timer interrupt is only used by the brightness engine.  Leaving it out when the engine is off keeps Timer2 free for
+// other uses (tone, for example).
+#if defined(ARDUINO) && defined(__AVR__) && useBrightnessEngine
+
+namespace
+{
+	void (*timerInterruptHandler)() = nullptr;
+
+	// Timer2 runs with a prescaler of 256, so one count is 16 microseconds on a 16 MHz board.
+	inline uint8_t timerCounts(unsigned int period)
+	{
+		return (uint8_t)((F_CPU / 1000000UL) * period / 256 - 1);
+	}
+}
+
+void HAL::startTimerInterrupt(void (*handler)(), unsigned int period)
+{
+	timerInterruptHandler = handler;
+
+	noInterrupts();
+	TCCR2A	= _BV(WGM21);
+	TCCR2B	= _BV(CS22) | _BV(CS21);
+	OCR2A	= timerCounts(period);
+	TCNT2	= 0;
+	TIMSK2	= _BV(OCIE2A);
+	interrupts();
+}
+
+void HAL::setTimerInterruptPeriod(unsigned int period)
+{
+	OCR2A = timerCounts(period);
+}
+
+ISR(TIMER2_COMPA_vect)
+{
+	timerInterruptHandler();
+}
+
+#elif defined(ARDUINO)
+
+	#if useBrightnessEngine
+		#error The timer interrupt used by the brightness engine is only implemented for the AVR.
+	#endif
+
+#endif
+
+// Without the AVR's Timer0 compare interrupt, the sample interrupt is run from the loop (see pollSampleInterrupt).  The
+// processor must not sleep then, nothing would wake it.
+#if defined(ARDUINO) && !defined(__AVR__)
+
+namespace
+{
+	void (*sampleInterruptHandler)() = nullptr;
+	void (*analogSampleHandler)(uint16_t value) = nullptr;
+	uint8_t analogSamplePin;
+	unsigned long lastSampleTime;
+
+	// Samples owed after a long pass through the loop are dropped beyond this many, the debouncing only needs a few.
+	const uint8_t maximumSamplesBehind = 8;
+}
+
+void HAL::startSampleInterrupt(void (*handler)())
+{
+	sampleInterruptHandler	= handler;
+	lastSampleTime			= ::micros();
+}
+
+void HAL::pollSampleInterrupt()
+{
+	unsigned long now = ::micros();
+
+	if (now - lastSampleTime > (unsigned long)maximumSamplesBehind * 1024)
+	{
+		lastSampleTime = now - (unsigned long)maximumSamplesBehind * 1024;
+	}
+
+	while (now - lastSampleTime >= 1024)
+	{
+		lastSampleTime += 1024;
+
+		if (sampleInterruptHandler != nullptr)
+		{
+			sampleInterruptHandler();
+		}
+
+		if (analogSampleHandler != nullptr)
+		{
+			analogSampleHandler(::analogRead(analogSamplePin));
+		}
+	}
+}
+
+void HAL::startAnalogSampling(uint8_t pin, void (*handler)(uint16_t value))
+{
+	analogSamplePin		= pin;
+	analogSampleHandler	= handler;
+}
+
+void HAL::sleep()
+{
+}
+
+void HAL::paintStack()
+{
+}
+
+unsigned int HAL::getFreeMemory()
+{
+	return 0;
+}
+
+unsigned int HAL::getLeastFreeMemory()
+{
+	return 0;
+}
+
+#endif
+
+#if !defined(ARDUINO)
+
+void HAL::startTimerInterrupt(void (*handler)(), unsigned int period)
+{
+	SimulatedHardware::instance().startTimer(SimulatedHardware::TIMER2, handler, period);
+}
+
+void HAL::setTimerInterruptPeriod(unsigned int period)
+{
+	SimulatedHardware::instance().setTimerPeriod(SimulatedHardware::TIMER2, period);
+}
+
+void HAL::startSampleInterrupt(void (*handler)())
+{
+	SimulatedHardware::instance().startTimer(SimulatedHardware::TIMER0, handler, 1024);
+}
+
+void HAL::startAnalogSampling(uint8_t pin, void (*handler)(uint16_t value))
+{
+	SimulatedHardware::instance().startAnalogSampling(pin, handler, 1024);
+}
+
+void HAL::sleep()
+{
+	SimulatedHardware::instance().sleep();
+}
+
+void HAL::paintStack()
+{
+}
+
+unsigned int HAL::getFreeMemory()
+{
+	return 0;
+}
+
+unsigned int HAL::getLeastFreeMemory()
+{
+	return 0;
+}
+
+#endif
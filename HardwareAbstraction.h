@@ -0,0 +1,159 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef HARDWAREABSTRACTION_H
+#define HARDWAREABSTRACTION_H
+
+// All access to the hardware (pins, time, the debug serial port, and the shift register and audio board libraries) goes
+// through here.  On the Arduino this simply forwards to the Arduino core and libraries.  Everywhere else (the host
+// simulator in the "Simulator" folder), it forwards to the simulated hardware so the generator can be built and run on
+// a workstation.
+#if defined(ARDUINO)
+	#include <Arduino.h>
+	#include "SoftwareSerial.h"
+#else
+	#include "SimulatedHardware.h"
+	#include "SoftwareSerial.h"
+#endif
+
+// The configuration selects the shift register backend.
+#include "Configuration.h"
+
+#if defined(ARDUINO)
+	#if shiftRegisterBackend == SHIFTREGISTERSPI
+		#include "SpiShiftRegister.h"
+	#else
+		#include "ShiftRegister74HC595.h"
+	#endif
+#endif
+
+namespace HAL
+{
+	// Output shift register and the serial port used to talk to the audio board.
+	#if defined(ARDUINO) && shiftRegisterBackend == SHIFTREGISTERSPI
+		template<uint8_t numberOfShiftRegisters> using ShiftRegister = SpiShiftRegister<numberOfShiftRegisters>;
+	#elif defined(ARDUINO)
+		template<uint8_t numberOfShiftRegisters> using ShiftRegister = ShiftRegister74HC595<numberOfShiftRegisters>;
+	#else
+		template<uint8_t numberOfShiftRegisters> using ShiftRegister = SimulatedShiftRegister<numberOfShiftRegisters, shiftRegisterBackend == SHIFTREGISTERSPI>;
+	#endif
+
+	typedef SoftwareSerial AudioSerial;
+
+	#if defined(ARDUINO)
+		// Time.
+		inline unsigned long millis()								{ return ::millis(); }
+		inline unsigned long micros()								{ return ::micros(); }
+		inline void delay(unsigned long milliseconds)				{ ::delay(milliseconds); }
+
+		// Pins.
+		inline void pinMode(uint8_t pin, uint8_t mode)				{ ::pinMode(pin, mode); }
+		inline int digitalRead(uint8_t pin)							{ return ::digitalRead(pin); }
+		inline void digitalWrite(uint8_t pin, uint8_t value)		{ ::digitalWrite(pin, value); }
+		inline int analogRead(uint8_t pin)							{ return ::analogRead(pin); }
+
+		// Debug serial port.
+		inline void debugBegin(unsigned long baud)					{ Serial.begin(baud); }
+		inline int debugAvailableForWrite()							{ return Serial.availableForWrite(); }
+		inline void debugWrite(uint8_t value)						{ Serial.write(value); }
+		inline int debugAvailable()									{ return Serial.available(); }
+		inline int debugRead()										{ return Serial.read(); }
+
+		// Interrupts.
+		inline void disableInterrupts()								{ noInterrupts(); }
+		inline void enableInterrupts()								{ interrupts(); }
+
+		// Copy a value out of a table stored in flash (PROGMEM).
+		template<typename T> inline T readProgramMemory(const T* address)
+		{
+			T value;
+			memcpy_P(&value, address, sizeof(T));
+			return value;
+		}
+	#else
+		// Time.
+		inline unsigned long millis()								{ return SimulatedHardware::instance().millis(); }
+		inline unsigned long micros()								{ return SimulatedHardware::instance().micros(); }
+		inline void delay(unsigned long milliseconds)				{ SimulatedHardware::instance().advance(1000*milliseconds); }
+
+		// Pins.
+		inline void pinMode(uint8_t pin, uint8_t mode)				{ SimulatedHardware::instance().pinMode(pin, mode); }
+		inline int digitalRead(uint8_t pin)							{ return SimulatedHardware::instance().digitalRead(pin); }
+		inline void digitalWrite(uint8_t pin, uint8_t value)		{ SimulatedHardware::instance().digitalWrite(pin, value); }
+		inline int analogRead(uint8_t pin)							{ return SimulatedHardware::instance().analogRead(pin); }
+
+		// Debug serial port.
+		inline void debugBegin(unsigned long baud)					{ SimulatedHardware::instance().getSerial().begin(baud); }
+		inline int debugAvailableForWrite()							{ return SimulatedHardware::instance().getSerial().availableForWrite(); }
+		inline void debugWrite(uint8_t value)						{ SimulatedHardware::instance().getSerial().write(value); }
+		inline int debugAvailable()									{ return SimulatedHardware::instance().getSerial().available(); }
+		inline int debugRead()										{ return SimulatedHardware::instance().getSerial().read(); }
+
+		// Interrupts.  Simulated interrupts only happen while the clock is advanced (by a delay or a pin access, for
+		// example), so they can land in the middle of the sketch's code just like the real ones.
+		inline void disableInterrupts()								{ SimulatedHardware::instance().disableInterrupts(); }
+		inline void enableInterrupts()								{ SimulatedHardware::instance().enableInterrupts(); }
+
+		// Copy a value out of a table stored in flash (PROGMEM).
+		template<typename T> inline T readProgramMemory(const T* address)	{ return *address; }
+	#endif
+
+	// Keeps the compiler from moving memory accesses across this point.  Data shared with an interrupt through an index
+	// (a ring buffer, for example) is written before the index is published and read before the index is moved on.
+	inline void memoryBarrier()										{ asm volatile("" ::: "memory"); }
+
+	// Periodic timer interrupt.  The handler is called every "period" microseconds.  The period can be changed from inside
+	// the handler to set when it is called next.  On the AVR this is Timer2, which has a resolution of 16 microseconds and
+	// a maximum period of 4096 microseconds.
+	void startTimerInterrupt(void (*handler)(), unsigned int period);
+	void setTimerInterruptPeriod(unsigned int period);
+
+	// Interrupt used to sample the inputs, called about once a millisecond (every 1024 microseconds).  On the AVR this
+	// piggybacks on Timer0, which the Arduino core already runs for millis, by using its compare A interrupt.  Other
+	// boards have no such interrupt, so there the handler is called from pollSampleInterrupt instead, once for every 1024
+	// microseconds that have gone by.  Call pollSampleInterrupt from the loop, it does nothing where there is an interrupt.
+	void startSampleInterrupt(void (*handler)());
+	#if defined(ARDUINO) && !defined(__AVR__)
+		void pollSampleInterrupt();
+	#else
+		inline void pollSampleInterrupt()							{ }
+	#endif
+
+	// Background conversions of one analog pin.  A conversion is started by the hardware at every sample interrupt (so that
+	// must be running) and "handler" is called with the result from the conversion complete interrupt.  The loop never
+	// waits for a conversion.  Don't use analogRead while this runs.  On boards other than the AVR, the pin is read with
+	// analogRead at every polled sample instead.
+	void startAnalogSampling(uint8_t pin, void (*handler)(uint16_t value));
+
+	// Sleep (AVR idle mode) until the next interrupt.  Returns once it has been handled.  Any interrupt wakes the
+	// processor: the timers, the ADC, the serial ports, and the pin changes SoftwareSerial listens to.  Other boards don't
+	// sleep, the samples are polled from the loop.
+	void sleep();
+
+	// Free RAM, between the end of the heap (or of the static data, when nothing has been allocated) and the stack.
+	// paintStack fills it with a pattern, so getLeastFreeMemory can later find how far down the stack has reached since.
+	// Call paintStack as early as possible.  Only measured on the AVR, elsewhere 0 is reported.
+	void paintStack();
+	unsigned int getFreeMemory();
+	unsigned int getLeastFreeMemory();
+
+	// RAM (bytes) taken by the static data on the AVR: the sample, analog and timer interrupt handlers.
+	const unsigned int staticBytes = (2 + useBrightnessEngine) * sizeof(void (*)());
+}
+
+#endif
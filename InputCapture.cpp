@@ -0,0 +1,121 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#include "InputCapture.h"
+
+InputCapture* InputCapture::_runningCapture = nullptr;
+
+InputCapture::InputCapture(uint8_t (*readInputs)()) :
+	_readInputs(readInputs),
+	_head(0),
+	_tail(0),
+	_overflow(false),
+	_numberOfOverflows(0),
+	_inputs(0),
+	_inputsTime(0),
+	_count0(0xFF),
+	_count1(0xFF)
+{
+}
+
+InputCapture::~InputCapture()
+{
+}
+
+void InputCapture::begin()
+{
+	_runningCapture = this;
+	HAL::startSampleInterrupt(interruptHandler);
+}
+
+bool InputCapture::read(InputEdge& edge)
+{
+	if (_tail != _head)
+	{
+		// The interrupt only writes an edge before it moves the head past it, so the edge is complete.  The slot is copied
+		// out before the tail hands it back.
+		edge	= _edges[_tail];
+		HAL::memoryBarrier();
+		_tail	= (_tail + 1) & (nInputEdges - 1);
+		return true;
+	}
+
+	if (_overflow)
+	{
+		// Edges were lost.  Hand back the latest sample so the caller catches up.  The sample is more than one byte, so
+		// the interrupt is held off while it is copied.
+		HAL::disableInterrupts();
+		edge.inputs	= _inputs;
+		edge.time	= _inputsTime;
+		_overflow	= false;
+		HAL::enableInterrupts();
+		return true;
+	}
+
+	return false;
+}
+
+uint8_t InputCapture::getInputs()
+{
+	return _inputs;
+}
+
+unsigned int InputCapture::getNumberOfOverflows()
+{
+	HAL::disableInterrupts();
+	unsigned int numberOfOverflows = _numberOfOverflows;
+	HAL::enableInterrupts();
+	return numberOfOverflows;
+}
+
+void InputCapture::interruptHandler()
+{
+	_runningCapture->sample();
+}
+
+void InputCapture::sample()
+{
+	// The counters of inputs that disagree with the debounced state count down, the others go back to 3.  A counter
+	// that rolls over (the 4th disagreeing sample in a row) flips its input.
+	uint8_t changed	= _inputs ^ _readInputs();
+	_count0			= ~(_count0 & changed);
+	_count1			= _count0 ^ (_count1 & changed);
+	changed			&= _count0 & _count1;
+
+	if (changed == 0)
+	{
+		return;
+	}
+
+	uint8_t inputs		= _inputs ^ changed;
+	unsigned long time	= HAL::micros();
+	_inputs				= inputs;
+	_inputsTime			= time;
+
+	uint8_t next = (_head + 1) & (nInputEdges - 1);
+	if (next == _tail)
+	{
+		_overflow = true;
+		_numberOfOverflows++;
+		return;
+	}
+
+	_edges[_head].time		= time;
+	_edges[_head].inputs	= inputs;
+	HAL::memoryBarrier();
+	_head					= next;
+}
@@ -0,0 +1,101 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#ifndef INPUTCAPTURE_H
+#define INPUTCAPTURE_H
+
+#include "HardwareAbstraction.h"
+
+// Number of edges that can be waiting to be read.  Must be a power of 2.
+#define nInputEdges 8
+
+// A change of the inputs.  Bit "i" of "inputs" is set when input "i" is active.  The time is in microseconds.
+struct InputEdge
+{
+	unsigned long				time;
+	uint8_t						inputs;
+};
+
+// Samples up to 8 inputs (the hall effect sensors and the buttons) from a timer interrupt about once a millisecond,
+// debounces them, and queues every change with the time it was seen.  The loop only has to read the queue, so no pins
+// are read when nothing has changed and no edge is lost if the loop is busy for a while.
+//
+// Each input has a 2 bit counter that counts the samples that disagree with its debounced state.  An input only changes
+// after 4 disagreeing samples in a row (about 4 milliseconds), and any sample that agrees starts the count over, so a
+// sensor chattering at the edge of a magnet stays where it was.  This is the hysteresis, and it also bounds the reaction
+// time: a clean change is always reported 4 samples after it happens.  The counters are kept "vertically" (bit "i" of
+// two bytes is the counter of input "i"), so all 8 inputs are filtered at once with a few bitwise operations.
+//
+// Pin change interrupts would catch edges sooner, but SoftwareSerial (the audio board) claims all of the pin change
+// interrupt vectors.  A millisecond is well below anything the arm can do.
+//
+// The queue is a single producer (the interrupt), single consumer (the loop) ring buffer.  Each side only writes its own
+// index, so no locking is needed.  If the queue fills up, new edges are dropped and the next read returns the latest
+// sample instead, so the loop still ends up with the current inputs.
+class InputCapture
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		// The inputs are read with "readInputs" (for example, FastInputPins::readActive), which is called from the
+		// interrupt.  The pins must already be set up.
+		InputCapture(uint8_t (*readInputs)());
+
+		// Default destructor.
+		~InputCapture();
+
+	// Public interface.
+	public:
+		// Start sampling.  Only one capture can run at a time.  The inputs start out as all
+		// inactive, so an input that is already active is reported as an edge once it has been debounced.
+		void begin();
+
+		// Get the oldest edge that has not been read.  Returns false if there is none.
+		bool read(InputEdge& edge);
+
+		// The most recent debounced inputs.
+		uint8_t getInputs();
+
+		// Number of edges dropped because the queue was full.
+		unsigned int getNumberOfOverflows();
+
+	private:
+		// Called by the timer interrupt to sample the pins.
+		static void interruptHandler();
+		void sample();
+
+	private:
+		static InputCapture*								_runningCapture;
+
+		uint8_t												(*_readInputs)();
+
+		InputEdge											_edges[nInputEdges];
+		volatile uint8_t									_head;
+		volatile uint8_t									_tail;
+		volatile bool										_overflow;
+		volatile unsigned int								_numberOfOverflows;
+
+		// Debounced inputs and when they last changed.
+		volatile uint8_t									_inputs;
+		volatile unsigned long								_inputsTime;
+
+		// Vertical counters of the samples that disagree with the debounced inputs (only used by the interrupt).
+		uint8_t												_count0;
+		uint8_t												_count1;
+};
+
+#endif
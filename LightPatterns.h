@@ -0,0 +1,67 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef LIGHTPATTERNS_H
+#define LIGHTPATTERNS_H
+
+#include "HardwareAbstraction.h"
+#include "enums.h"
+
+// Frames of the blue light patterns.  Each frame is the state of all the blue lights, bit 0 being the first blue light.
+// Shifted to the first blue light's output (see DerivedProfile in Configuration.h), it is written to the outputs under
+// the blue light mask, so a pattern is changed with one masked write whatever the number of lights that change.  The
+// frames are worked out by the compiler and stored in flash.
+namespace PATTERN
+{
+	// The first "numberOfLights" blue lights on.
+	constexpr LIGHT::MASK barGraph(uint8_t numberOfLights)
+	{
+		return numberOfLights == 0 ? 0 : barGraph(numberOfLights - 1) | LIGHT::maskOf(numberOfLights - 1);
+	}
+
+	// Only the blue light at "position" (0 is BLUE1) on.
+	constexpr LIGHT::MASK scroller(uint8_t position)
+	{
+		return LIGHT::maskOf(position);
+	}
+}
+
+static_assert(LIGHT::NUMBEROFBLUELIGHTS == 5, "The blue light frame tables are written for 5 blue lights.");
+
+// Bar graph of 0 to 5 lights.  Used for the battery meter and, alternated with all lights off, for blinking numbers.
+const LIGHT::MASK barGraphFrames[LIGHT::NUMBEROFBLUELIGHTS + 1] PROGMEM =
+{
+	PATTERN::barGraph(0),
+	PATTERN::barGraph(1),
+	PATTERN::barGraph(2),
+	PATTERN::barGraph(3),
+	PATTERN::barGraph(4),
+	PATTERN::barGraph(5)
+};
+
+// Positions of the scrolling blue light.
+const LIGHT::MASK scrollerFrames[LIGHT::NUMBEROFBLUELIGHTS] PROGMEM =
+{
+	PATTERN::scroller(0),
+	PATTERN::scroller(1),
+	PATTERN::scroller(2),
+	PATTERN::scroller(3),
+	PATTERN::scroller(4)
+};
+
+#endif
@@ -0,0 +1,193 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+// Generated from LightSequences.txt by NaquadahSequenceCompiler.  Edit the text and compile it again, do not edit this file.
+
+#ifndef LIGHTSEQUENCES_H
+#define LIGHTSEQUENCES_H
+
+#include "Animation.h"
+
+// RampBlueLightsOn, 12 bytes.
+const uint8_t sequenceRampBlueLightsOn[] PROGMEM =
+{
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE1),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE2),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE3),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE4),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE5),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// RampBlueLightsOff, 12 bytes.
+const uint8_t sequenceRampBlueLightsOff[] PROGMEM =
+{
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE5),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE4),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE3),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE2),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE1),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// RampUpAllLights, 16 bytes.
+const uint8_t sequenceRampUpAllLights[] PROGMEM =
+{
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE1),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE2),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE3),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE4),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE5),
+	animationStep(2, ANIMATION::LIGHTON, LIGHT::GREEN),
+	animationStep(2, ANIMATION::LIGHTON, LIGHT::WHITE),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// RampDownAllLights, 20 bytes.
+const uint8_t sequenceRampDownAllLights[] PROGMEM =
+{
+	animationStep(0, ANIMATION::LIGHTOFF, LIGHT::WHITE),
+	animationStep(2, ANIMATION::LIGHTOFF, LIGHT::GREEN),
+	animationStep(0, ANIMATION::LIGHTOFF, LIGHT::RED),
+	animationStep(1, ANIMATION::WAIT, 0),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE5),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE4),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE3),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE2),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE1),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// StartUp, 38 bytes.
+const uint8_t sequenceStartUp[] PROGMEM =
+{
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE1),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE2),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE3),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE4),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE5),
+	animationStep(2, ANIMATION::LIGHTON, LIGHT::GREEN),
+	animationStep(2, ANIMATION::LIGHTON, LIGHT::WHITE),
+	animationStep(12, ANIMATION::WAIT, 0),
+	animationStep(0, ANIMATION::LIGHTOFF, LIGHT::WHITE),
+	animationStep(2, ANIMATION::LIGHTOFF, LIGHT::GREEN),
+	animationStep(0, ANIMATION::LIGHTOFF, LIGHT::RED),
+	animationStep(1, ANIMATION::WAIT, 0),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE5),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE4),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE3),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE2),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::BLUE1),
+	animationStep(0, ANIMATION::READYON, 0),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// BlinkBlueLights, 10 bytes.
+const uint8_t sequenceBlinkBlueLights[] PROGMEM =
+{
+	animationStep(0, ANIMATION::REPEAT, 3),
+	animationStep(1, ANIMATION::BLUELIGHTSON, ANIMATION::ARGUMENT),
+	animationStep(1, ANIMATION::BLUELIGHTSOFF, 0),
+	animationStep(0, ANIMATION::LOOP, 0),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// BlinkBlueLightsRolledOver, 12 bytes.
+const uint8_t sequenceBlinkBlueLightsRolledOver[] PROGMEM =
+{
+	animationStep(0, ANIMATION::REPEAT, 3),
+	animationStep(0, ANIMATION::BLUELIGHTSON, 5),
+	animationStep(2, ANIMATION::BLUELIGHTSON, ANIMATION::ARGUMENT),
+	animationStep(1, ANIMATION::BLUELIGHTSOFF, 0),
+	animationStep(0, ANIMATION::LOOP, 0),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// OverloadCritical, 14 bytes.
+const uint8_t sequenceOverloadCritical[] PROGMEM =
+{
+	animationStep(0, ANIMATION::AUDIOTRIGGER, AUDIO::OVERLOAD),
+	animationStep(0, ANIMATION::SYNC, 0),
+	animationStep(0, ANIMATION::LIGHTOFF, LIGHT::WHITE),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::WHITE),
+	animationStep(1, ANIMATION::LIGHTOFF, LIGHT::WHITE),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::WHITE),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// BatteryMeterMode, 4 bytes.
+const uint8_t sequenceBatteryMeterMode[] PROGMEM =
+{
+	animationStep(0, ANIMATION::BATTERYMETER, 0),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// RampUpMode, 20 bytes.
+const uint8_t sequenceRampUpMode[] PROGMEM =
+{
+	animationStep(0, ANIMATION::READYOFF, 0),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE1),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE2),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE3),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE4),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE5),
+	animationStep(2, ANIMATION::LIGHTON, LIGHT::GREEN),
+	animationStep(2, ANIMATION::LIGHTON, LIGHT::WHITE),
+	animationStep(0, ANIMATION::READYON, 0),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// BlueLightsMode, 4 bytes.
+const uint8_t sequenceBlueLightsMode[] PROGMEM =
+{
+	animationStep(0, ANIMATION::BLUELIGHTSON, 5),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// WhiteLightMode, 4 bytes.
+const uint8_t sequenceWhiteLightMode[] PROGMEM =
+{
+	animationStep(0, ANIMATION::LIGHTON, LIGHT::WHITE),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// GreenAndRedLightsMode, 6 bytes.
+const uint8_t sequenceGreenAndRedLightsMode[] PROGMEM =
+{
+	animationStep(0, ANIMATION::LIGHTON, LIGHT::GREEN),
+	animationStep(0, ANIMATION::LIGHTON, LIGHT::RED),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// PowerTestMode, 18 bytes.
+const uint8_t sequencePowerTestMode[] PROGMEM =
+{
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE1),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE2),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE3),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE4),
+	animationStep(1, ANIMATION::LIGHTON, LIGHT::BLUE5),
+	animationStep(2, ANIMATION::LIGHTON, LIGHT::GREEN),
+	animationStep(2, ANIMATION::LIGHTON, LIGHT::WHITE),
+	animationStep(0, ANIMATION::LIGHTON, LIGHT::RED),
+	animationStep(0, ANIMATION::END, 0)
+};
+
+// 14 sequences, 190 bytes of flash.
+#define lightSequenceBytes 190
+
+#endif
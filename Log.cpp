@@ -0,0 +1,167 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#include "Log.h"
+
+static_assert(DEBUGOFF == DEBUG::OFF && DEBUGSTANDARD == DEBUG::STANDARD && DEBUGVERBOSE == DEBUG::VERBOSE, "The debug levels in Configuration.h must match DEBUG::DEBUGLEVEL.");
+
+char			Log::_buffer[nLogBufferBytes];
+uint8_t			Log::_head			= 0;
+uint8_t			Log::_tail			= 0;
+unsigned long	Log::_bytesQueued	= 0;
+unsigned long	Log::_bytesDropped	= 0;
+uint8_t			Log::_maximumUsed	= 0;
+
+void Log::begin(unsigned long baud)
+{
+	HAL::debugBegin(baud);
+}
+
+void Log::print(const char message[])
+{
+	size_t length = 0;
+	while (message[length] != '\0')
+	{
+		length++;
+	}
+
+	queue(message, length > nLogBufferBytes - 1 ? nLogBufferBytes - 1 : length);
+}
+
+void Log::print(const __FlashStringHelper* message)
+{
+	// Copy the string out of flash a piece at a time.  Each piece is queued on its own, so a long string may be cut off
+	// if the buffer is nearly full.
+	const char*	address = reinterpret_cast<const char*>(message);
+	char		piece[16];
+	uint8_t		length;
+
+	do
+	{
+		length = 0;
+		while (length < sizeof(piece))
+		{
+			char character = HAL::readProgramMemory(address);
+			if (character == '\0')
+			{
+				break;
+			}
+			piece[length++] = character;
+			address++;
+		}
+		queue(piece, length);
+	}
+	while (length == sizeof(piece));
+}
+
+void Log::print(long message)
+{
+	if (message < 0)
+	{
+		queue("-", 1);
+		print(0UL - (unsigned long)message);
+	}
+	else
+	{
+		print((unsigned long)message);
+	}
+}
+
+void Log::print(unsigned long message)
+{
+	// Digits are produced from the right.
+	char	digits[10];
+	uint8_t	start = sizeof(digits);
+
+	do
+	{
+		digits[--start]	= '0' + message % 10;
+		message		   /= 10;
+	}
+	while (message > 0);
+
+	queue(digits + start, sizeof(digits) - start);
+}
+
+void Log::update()
+{
+	int available = HAL::debugAvailableForWrite();
+
+	while (available > 0 && _tail != _head)
+	{
+		HAL::debugWrite(_buffer[_tail]);
+		_tail = (_tail + 1) & (nLogBufferBytes - 1);
+		available--;
+	}
+}
+
+unsigned long Log::getBytesQueued()
+{
+	return _bytesQueued;
+}
+
+unsigned long Log::getBytesDropped()
+{
+	return _bytesDropped;
+}
+
+uint8_t Log::getMaximumUsed()
+{
+	return _maximumUsed;
+}
+
+void Log::resetStatistics()
+{
+	_bytesQueued	= 0;
+	_bytesDropped	= 0;
+	_maximumUsed	= getUsed();
+}
+
+uint8_t Log::getFree()
+{
+	return nLogBufferBytes - 1 - getUsed();
+}
+
+uint8_t Log::getUsed()
+{
+	return (_head - _tail) & (nLogBufferBytes - 1);
+}
+
+void Log::queue(const char message[], uint8_t length)
+{
+	// One slot is always left empty to tell a full buffer from an empty one.
+	uint8_t used = getUsed();
+
+	if (length > nLogBufferBytes - 1 - used)
+	{
+		_bytesDropped += length;
+		return;
+	}
+
+	for (uint8_t i = 0; i < length; i++)
+	{
+		_buffer[_head]	= message[i];
+		_head			= (_head + 1) & (nLogBufferBytes - 1);
+	}
+
+	_bytesQueued += length;
+	used		 += length;
+	if (used > _maximumUsed)
+	{
+		_maximumUsed = used;
+	}
+}
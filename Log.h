@@ -0,0 +1,87 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#ifndef LOG_H
+#define LOG_H
+
+#include "HardwareAbstraction.h"
+#include "Configuration.h"
+
+// Debugging messages.  Use these instead of calling Log directly.  The level is checked at compile time, so a message
+// above "debugLevel" costs nothing, not even the flash for its string.  Wrap strings in F() to keep them out of SRAM.
+//
+//	logPrint(DEBUG::STANDARD, F("Special mode: "));
+//	logPrintLn(DEBUG::STANDARD, mode);
+#define logPrint(level, message)		do { if ((level) <= debugLevel) Log::print(message); } while (0)
+#define logPrintLn(level, message)		do { if ((level) <= debugLevel) Log::printLn(message); } while (0)
+
+// Queues debugging messages in a ring buffer and sends them out over the serial port a little at a time from update, so
+// printing never waits on the serial port.  A call costs the time to copy its text into the buffer.  Each piece of a
+// message (a string, a number, the line ending) either fits in the buffer completely or is dropped.
+//
+// Only used from the loop (not from interrupts).
+class Log
+{
+	// Public interface.
+	public:
+		// Start the serial port.
+		static void begin(unsigned long baud);
+
+		static void print(const char message[]);
+		static void print(const __FlashStringHelper* message);
+		static void print(long message);
+		static void print(unsigned long message);
+		static void print(int message)							{ print((long)message); }
+		static void print(unsigned int message)					{ print((unsigned long)message); }
+
+		template<typename T> static void printLn(T message)
+		{
+			print(message);
+			print("\r\n");
+		}
+
+		// Send as much of the buffer as the serial port can take without blocking.  Call from the loop.
+		static void update();
+
+		// Number of bytes that can be queued right now.
+		static uint8_t getFree();
+
+		// Statistics.
+		static unsigned long getBytesQueued();
+		static unsigned long getBytesDropped();
+		static uint8_t getMaximumUsed();
+		static void resetStatistics();
+
+	private:
+		static uint8_t getUsed();
+		static void queue(const char message[], uint8_t length);
+
+	private:
+		static char											_buffer[nLogBufferBytes];
+		static uint8_t										_head;
+		static uint8_t										_tail;
+
+		static unsigned long								_bytesQueued;
+		static unsigned long								_bytesDropped;
+		static uint8_t										_maximumUsed;
+
+	public:
+		// RAM (bytes) taken by the static data.
+		static constexpr unsigned int staticBytes = sizeof(_buffer) + sizeof(_head) + sizeof(_tail) + sizeof(_bytesQueued) + sizeof(_bytesDropped) + sizeof(_maximumUsed);
+};
+
+#endif
@@ -0,0 +1,260 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#include "LoopStatistics.h"
+
+#if useLoopStatistics
+
+static_assert(nLogBufferBytes - 1 >= 12 + 11*nLoopHistogramBuckets, "The debug log buffer is too small for the loop statistics report.");
+static_assert(SCHEDULER::NUMBEROFTIMERS <= nLoopHistogramBuckets, "The dispatch line of the loop statistics report must not be longer than the histogram line.");
+
+LoopStatistics::LoopStatistics() :
+	#if useBrightnessEngine
+		_brightnessEngine(nullptr),
+	#endif
+	_reportLine(0)
+{
+	reset();
+}
+
+LoopStatistics::~LoopStatistics()
+{
+}
+
+void LoopStatistics::recordLoop(unsigned long time)
+{
+	uint8_t bucket = 0;
+	while (bucket < nLoopHistogramBuckets - 1 && time >= (16UL << bucket))
+	{
+		bucket++;
+	}
+	_histogram[bucket]++;
+
+	if (_loops == 0 || time < _minimumLoopTime)
+	{
+		_minimumLoopTime = time;
+	}
+	if (time > _maximumLoopTime)
+	{
+		_maximumLoopTime = time;
+	}
+
+	_totalLoopTime += time;
+	_loops++;
+}
+
+void LoopStatistics::recordLightStep(unsigned long late)
+{
+	if (late > _maximumLightLate)
+	{
+		_maximumLightLate = late;
+	}
+
+	_totalLightLate += late;
+	_lightSteps++;
+}
+
+void LoopStatistics::recordLatch()
+{
+	_latches++;
+}
+
+void LoopStatistics::recordSleep(unsigned long time)
+{
+	_sleeps++;
+	_sleepMilliseconds	+= time / 1000;
+	_sleepMicroseconds	+= time % 1000;
+
+	if (_sleepMicroseconds >= 1000)
+	{
+		_sleepMicroseconds -= 1000;
+		_sleepMilliseconds++;
+	}
+}
+
+void LoopStatistics::recordDispatch(uint8_t timer, unsigned long time)
+{
+	if (time > _maximumDispatchTimes[timer])
+	{
+		_maximumDispatchTimes[timer] = time;
+	}
+
+	_dispatches++;
+}
+
+void LoopStatistics::reset()
+{
+	_startTime			= HAL::millis();
+	_loops				= 0;
+	_totalLoopTime		= 0;
+	_minimumLoopTime	= 0;
+	_maximumLoopTime	= 0;
+	_lightSteps			= 0;
+	_totalLightLate		= 0;
+	_maximumLightLate	= 0;
+	_latches			= 0;
+	_sleeps				= 0;
+	_sleepMilliseconds	= 0;
+	_sleepMicroseconds	= 0;
+	_dispatches			= 0;
+
+	for (uint8_t i = 0; i < nLoopHistogramBuckets; i++)
+	{
+		_histogram[i] = 0;
+	}
+
+	for (uint8_t i = 0; i < SCHEDULER::NUMBEROFTIMERS; i++)
+	{
+		_maximumDispatchTimes[i] = 0;
+	}
+
+	#if useBrightnessEngine
+		if (_brightnessEngine != nullptr)
+		{
+			_brightnessEngine->resetStatistics();
+		}
+	#endif
+}
+
+#if useBrightnessEngine
+	void LoopStatistics::setBrightnessEngine(BrightnessStatistics* brightnessEngine)
+	{
+		_brightnessEngine = brightnessEngine;
+		_brightnessEngine->resetStatistics();
+	}
+#endif
+
+void LoopStatistics::report()
+{
+	_reportLine = 1;
+}
+
+void LoopStatistics::update()
+{
+	// Only whole lines go into the log, so wait until there is room for the longest (the histogram).
+	if (_reportLine == 0 || Log::getFree() < 12 + 11*nLoopHistogramBuckets)
+	{
+		return;
+	}
+
+	switch (_reportLine)
+	{
+		case 1:
+		{
+			Log::print(F("LOOP "));
+			Log::print(_loops);
+			Log::print(" ");
+			Log::print(_minimumLoopTime);
+			Log::print(" ");
+			Log::print(_loops ? _totalLoopTime / _loops : 0);
+			Log::print(" ");
+			Log::print(_maximumLoopTime);
+			Log::print(" ");
+			Log::printLn(HAL::millis() - _startTime);
+			break;
+		}
+
+		case 2:
+		{
+			Log::print(F("HISTOGRAM"));
+			for (uint8_t i = 0; i < nLoopHistogramBuckets; i++)
+			{
+				Log::print(" ");
+				Log::print(_histogram[i]);
+			}
+			Log::printLn("");
+			break;
+		}
+
+		case 3:
+		{
+			Log::print(F("LIGHT "));
+			Log::print(_lightSteps);
+			Log::print(" ");
+			Log::print(_lightSteps ? _totalLightLate / _lightSteps : 0);
+			Log::print(" ");
+			Log::print(_maximumLightLate);
+			Log::print(" ");
+			Log::printLn(_totalLightLate);
+			break;
+		}
+
+		case 4:
+		{
+			Log::print(F("LATCHES "));
+			Log::printLn(_latches);
+			break;
+		}
+
+		case 5:
+		{
+			unsigned long elapsed	= HAL::millis() - _startTime;
+			unsigned long awake		= elapsed > _sleepMilliseconds ? elapsed - _sleepMilliseconds : 0;
+
+			// Scale both down when 100 times the time awake would overflow (after about 12 hours awake).
+			while (awake > 0xFFFFFFFFUL / 100)
+			{
+				awake	>>= 1;
+				elapsed	>>= 1;
+			}
+
+			Log::print(F("SLEEP "));
+			Log::print(_sleeps);
+			Log::print(" ");
+			Log::print(_sleepMilliseconds);
+			Log::print(" ");
+			Log::printLn(elapsed > 0 ? 100*awake / elapsed : 100);
+			break;
+		}
+
+		case 6:
+		{
+			Log::print(F("DISPATCH "));
+			Log::print(_dispatches);
+			for (uint8_t i = 0; i < SCHEDULER::NUMBEROFTIMERS; i++)
+			{
+				Log::print(" ");
+				Log::print(_maximumDispatchTimes[i]);
+			}
+			Log::printLn("");
+			break;
+		}
+
+		default:
+		{
+			#if useBrightnessEngine
+				if (_brightnessEngine != nullptr)
+				{
+					unsigned long refreshes = _brightnessEngine->getNumberOfRefreshes();
+
+					Log::print(F("BRIGHTNESS "));
+					Log::print(refreshes);
+					Log::print(" ");
+					Log::print(refreshes ? _brightnessEngine->getTotalRefreshTime() / refreshes : 0);
+					Log::print(" ");
+					Log::printLn(_brightnessEngine->getMaximumRefreshTime());
+				}
+			#endif
+			_reportLine = 0;
+			return;
+		}
+	}
+
+	_reportLine++;
+}
+
+#endif
@@ -0,0 +1,118 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#ifndef LOOPSTATISTICS_H
+#define LOOPSTATISTICS_H
+
+#include "HardwareAbstraction.h"
+#include "Configuration.h"
+#include "enums.h"
+#include "Log.h"
+#include "BrightnessEngine.h"
+
+// Number of buckets in the loop time histogram.  Bucket 0 counts loops under 16 microseconds, and each bucket after it
+// covers twice the time of the one before.  The last bucket counts everything longer.
+#define nLoopHistogramBuckets 10
+
+// Timing counters for the main loop.  They record how long each pass through update takes, how late the scrolling blue
+// light steps are compared to when they were scheduled, how long the timers take to run, and how often the shift
+// registers are latched.  Recording costs a few microseconds a loop.
+//
+// The report is sent out through the debug log, one line per loop as room allows:
+//
+//	LOOP <loops> <minimum> <mean> <maximum> <elapsed>		Update times (microseconds) and time counted (milliseconds).
+//	HISTOGRAM <count> <count> ...							Loops in each histogram bucket.
+//	LIGHT <steps> <mean late> <maximum late> <total late>	Blue light step lateness (milliseconds).  Steps are
+//															scheduled from the deadline, so lateness does not add up.
+//	LATCHES <latches>										Shift register updates.
+//	SLEEP <sleeps> <asleep> <awake percent>					Idle sleeps and the time (milliseconds) spent asleep.
+//	DISPATCH <dispatches> <maximum> ...						Timers run and the longest (microseconds) each timer
+//															(SCHEDULER::TIMER order) took to run.
+//	BRIGHTNESS <refreshes> <mean> <maximum>					Brightness engine refreshes and the processor time
+//															(microseconds) one takes in its interrupts.  Only sent
+//															when the brightness engine is turned on.
+class LoopStatistics
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		LoopStatistics();
+
+		// Default destructor.
+		~LoopStatistics();
+
+	// Public interface.
+	public:
+		// Record one pass through the loop that took "time" microseconds.
+		void recordLoop(unsigned long time);
+
+		// Record a blue light step that was handled "late" milliseconds after it was due.
+		void recordLightStep(unsigned long late);
+
+		// Record a shift register update.
+		void recordLatch();
+
+		// Record a sleep that lasted "time" microseconds.
+		void recordSleep(unsigned long time);
+
+		// Record a timer (SCHEDULER::TIMER) that took "time" microseconds to run.
+		void recordDispatch(uint8_t timer, unsigned long time);
+
+		#if useBrightnessEngine
+			// The brightness engine keeps its own counters.  They are reported and cleared with these.
+			void setBrightnessEngine(BrightnessStatistics* brightnessEngine);
+		#endif
+
+		// Start from zero.
+		void reset();
+
+		// Start sending the report.  update sends it.
+		void report();
+		void update();
+
+	private:
+		unsigned long										_startTime;
+
+		unsigned long										_loops;
+		unsigned long										_totalLoopTime;
+		unsigned long										_minimumLoopTime;
+		unsigned long										_maximumLoopTime;
+		unsigned long										_histogram[nLoopHistogramBuckets];
+
+		unsigned long										_lightSteps;
+		unsigned long										_totalLightLate;
+		unsigned long										_maximumLightLate;
+
+		unsigned long										_latches;
+
+		// The time asleep is kept in milliseconds so it doesn't overflow, with the microseconds left over.
+		unsigned long										_sleeps;
+		unsigned long										_sleepMilliseconds;
+		unsigned int										_sleepMicroseconds;
+
+		unsigned long										_dispatches;
+		unsigned long										_maximumDispatchTimes[SCHEDULER::NUMBEROFTIMERS];
+
+		#if useBrightnessEngine
+			BrightnessStatistics*							_brightnessEngine;
+		#endif
+
+		// Report progress.  Zero when no report is being sent.
+		uint8_t												_reportLine;
+};
+
+#endif
@@ -0,0 +1,78 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "MemoryReport.h"
+
+#if useMemoryReport
+
+// The longest line is a component with a name of up to 16 characters.
+#define memoryReportLineBytes 40
+
+static_assert(nLogBufferBytes - 1 >= memoryReportLineBytes, "The debug log buffer is too small for the memory report.");
+
+MemoryReport::MemoryReport(const MemoryComponent* components, uint8_t numberOfComponents) :
+	_components(components),
+	_numberOfComponents(numberOfComponents),
+	_reportLine(0)
+{
+}
+
+MemoryReport::~MemoryReport()
+{
+}
+
+void MemoryReport::begin()
+{
+	HAL::paintStack();
+}
+
+void MemoryReport::report()
+{
+	_reportLine = 1;
+}
+
+void MemoryReport::update()
+{
+	// Wait for room for a whole line, so a line is never cut short.
+	if (_reportLine == 0 || Log::getFree() < memoryReportLineBytes)
+	{
+		return;
+	}
+
+	if (_reportLine <= _numberOfComponents)
+	{
+		MemoryComponent component = HAL::readProgramMemory(&_components[_reportLine - 1]);
+		Log::print(F("MEMORY "));
+		Log::print((const __FlashStringHelper*)component.name);
+		Log::print(" ");
+		Log::print(component.ram);
+		Log::print(" ");
+		Log::printLn(component.flash);
+		_reportLine++;
+	}
+	else
+	{
+		Log::print(F("FREE "));
+		Log::print(HAL::getFreeMemory());
+		Log::print(" ");
+		Log::printLn(HAL::getLeastFreeMemory());
+		_reportLine = 0;
+	}
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef MEMORYREPORT_H
+#define MEMORYREPORT_H
+
+#include "HardwareAbstraction.h"
+#include "Configuration.h"
+#include "enums.h"
+#include "Log.h"
+
+// RAM (bytes) the Arduino core and libraries keep for themselves, counted from their sources (Arduino AVR core 1.8):
+//	Serial				157		The HardwareSerial object (29) with its 64 byte receive and transmit buffers.
+//	SoftwareSerial		68		The 64 byte receive buffer shared by all ports, its head and tail, and the active port.
+//	millis				9		The Timer0 overflow count, the milliseconds, and their fraction.
+//	malloc				10		__brkval and the other heap variables, linked in by the free RAM measurement.
+// The build checks the static data against the RAM with this (in NaquadahGenerator.cpp).  The MEMORY lines of the
+// report give the real sizes on the board, compare their total with the data and bss sizes printed by the build.
+#define nArduinoCoreBytes (157 + 68 + 9 + 10)
+
+// A row of the memory report.  The name is stored in flash (PROGMEM).
+struct MemoryComponent
+{
+	const char*					name;
+	unsigned int				ram;
+	unsigned int				flash;
+};
+
+// Memory budget report.  The ATmega328P has 2 KB of RAM for the static data (the generator is allocated statically,
+// nothing uses the heap) and the stack.  The size of each part of the generator is known to the compiler and reported
+// as it is.  How deep the stack has gone is measured by painting the free RAM at start up (see HAL::paintStack).  The
+// flash taken by the code is not known until the program is linked, so only the flash tables are reported.
+//
+// The report is sent out through the debug log, one line per loop as room allows:
+//
+//	MEMORY <component> <RAM> <flash>		RAM and flash (bytes) taken by the component's data.  GENERATOR is the
+//											whole generator, the components after it up to LOG are parts of it.
+//	FREE <free> <least free>				Free RAM (bytes) now, and the least there has been since start up.
+class MemoryReport
+{
+	// Constructors.
+	public:
+		// Default contstructor.  The components are a table stored in flash (PROGMEM).
+		MemoryReport(const MemoryComponent* components, uint8_t numberOfComponents);
+
+		// Default destructor.
+		~MemoryReport();
+
+	// Public interface.
+	public:
+		// Paint the free RAM.  Call once, as early as possible.
+		void begin();
+
+		// Start sending the report.  update sends it.
+		void report();
+		void update();
+
+	private:
+		const MemoryComponent*								_components;
+		uint8_t												_numberOfComponents;
+
+		// Report progress.  Zero when no report is being sent.
+		uint8_t												_reportLine;
+};
+
+#endif
@@ -18,29 +18,10 @@
 /*
 	You must have the following libraries to run this software.
 
-	Bounce2 by Thomas Ouellet Fredericks, et al.
-		- Can be installed from Arduino IDE Library Manager.
-		- https://github.com/thomasfredericks/Bounce2
-
-	SoftTimers by Antoine Beauchamp
-		- Be careful to get the right library, there are several timer libraries and even more than one "SoftTimer" library.
-		- Can be installed from Arduino IDE Library Manager.
-		- https://github.com/end2endzone/SoftTimers
-
 	ShiftRegister74HC595 by Timo Denk
 		- Can be installed from Arduino IDE Library Manager.
 		- https://shiftregister.simsso.de
 
-	BatteryMeter by Lance A. Endres
-		- If you recieved this code as part of an archive (zip) it should have been included.
-		- Can be installed from Arduino IDE Library Manager.
-		- https://github.com/lendres/BatteryMeter-Arduino
-
-	ButtonSuite by Lance A. Endres
-		- If you recieved this code as part of an archive (zip) it should have been included.
-		- Can be installed from Arduino IDE Library Manager.
-		- https://github.com/lendres/ButtonSuite-Arduino
-
 	VS1000UART by Lance A. Endres
 		- Audio interface modified from the Adafruit Soundboard code.
 		- If you recieved this code as part of an archive (zip) it should have been included.
@@ -48,33 +29,31 @@
 
 
 #include "enums.h"
-#include "configuration.h"
+#include "Configuration.h"
 #include "NaquadahGenerator.h"
 #include "ShiftRegister74HC595.h"
 
 #define BATTERYMETERDEBUG
 
-Configuration       configuration;
-//NaquadahGenerator   naquadahGenerator(&configuration);
-NaquadahGenerator*   naquadahGenerator;
+// Allocated statically, so its size is part of the RAM use reported when the sketch is built.  The hardware is started
+// in begin.
+NaquadahGenerator<Configuration>	naquadahGenerator;
 
 // Setup function.
 void setup()
 {
-	if (configuration.DebugLevel > DEBUG::OFF)
+	if (debugLevel > DEBUG::OFF)
 	{
-		Serial.begin(9600);
-		Serial.println("Naquadah Generator debuging on.");
+		Log::begin(9600);
+		logPrintLn(DEBUG::STANDARD, F("Naquadah Generator debuging on."));
 	}
 
-	naquadahGenerator = new NaquadahGenerator(&configuration);
-
-	naquadahGenerator->begin();
+	naquadahGenerator.begin();
 }
 
 // Main loop.
 void loop()
 {
 	// Check the state and update as needed.
-	naquadahGenerator->update();
+	naquadahGenerator.update();
 }
\ No newline at end of file
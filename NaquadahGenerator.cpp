@@ -16,38 +16,148 @@
 */
 
 #include "NaquadahGenerator.h"
-//#include "LightSequences.h"
-
-NaquadahGenerator::NaquadahGenerator(Configuration* configuration) :
-	_configuration(configuration),
-	_shiftRegister(_configuration->shiftRegisterDataPin, _configuration->shiftRegisterClockPin, _configuration->shiftRegisterLatchPin),
-	_batteryMeter(&_shiftRegister, _configuration->batteryMinReading, _configuration->batteryMaxReading, Battery::LEVEL5),
-	_batteryMeterButton(_configuration->batteryMeterActivationPin),
-	_modeButton(_configuration->modeButtonPin, GENERATOR::NUMBEROFSPECIALMODES-1),
+#include "LightSequences.h"
+#include "LightPatterns.h"
+
+static_assert(SCHEDULER::NUMBEROFTIMERS <= nSchedulerTimers, "The scheduler doesn't have room for all of the generator's timers.");
+
+#if useAudioSerial
+	// Files on the audio board played for the audio triggers, in 8.3 form without the dot.  Keep the list in
+	// Configuration.h (useAudioSerial) up to date.
+	const char audioFileOn[] PROGMEM			= "NQHGENONOGG";
+	const char audioFileStateChange[] PROGMEM	= "STATECHGOGG";
+	const char audioFileOverload[] PROGMEM		= "OVERLOADOGG";
+#endif
+
+// RAM (bytes) taken by the interrupts: the objects they run (the input capture, the battery monitor, and the brightness
+// engine) and the handlers of the hardware abstraction.
+const unsigned int nInterruptBytes = sizeof(InputCapture*) + sizeof(BatteryMonitor*) + useBrightnessEngine*sizeof(BrightnessEngine<Configuration>*) + HAL::staticBytes;
+
+#if useMemoryReport
+	const char memoryGenerator[] PROGMEM			= "GENERATOR";
+	const char memoryShiftRegister[] PROGMEM		= "SHIFTREGISTER";
+	const char memoryOutputFrame[] PROGMEM			= "OUTPUTFRAME";
+	const char memoryScheduler[] PROGMEM			= "SCHEDULER";
+	const char memoryBatteryMonitor[] PROGMEM		= "BATTERYMONITOR";
+	const char memoryInputs[] PROGMEM				= "INPUTS";
+	const char memoryOverload[] PROGMEM				= "OVERLOAD";
+	const char memoryAnimation[] PROGMEM			= "ANIMATION";
+	const char memoryAudioPulses[] PROGMEM			= "AUDIOPULSES";
+	const char memoryAudioSerial[] PROGMEM			= "AUDIOSERIAL";
+	const char memoryAudioQueue[] PROGMEM			= "AUDIOQUEUE";
+	const char memoryLoopStatistics[] PROGMEM		= "LOOPSTATISTICS";
+	const char memoryMemoryReport[] PROGMEM			= "MEMORYREPORT";
+	const char memoryLog[] PROGMEM					= "LOG";
+	const char memoryTrace[] PROGMEM				= "TRACE";
+	const char memoryInterrupts[] PROGMEM			= "INTERRUPTS";
+	const char memoryOutputMap[] PROGMEM			= "OUTPUTMAP";
+	const char memoryArduino[] PROGMEM				= "ARDUINO";
+
+	// The rows of the memory report.  The parts of the generator follow it, the rest are outside of it.
+	template<typename Profile>
+	const MemoryComponent NaquadahGenerator<Profile>::_memoryComponents[] PROGMEM =
+	{
+		//	Name						RAM										Flash
+		{	memoryGenerator,			sizeof(NaquadahGenerator),				sizeof(_stateHandlers) + sizeof(_specialModeHandlers) + sizeof(barGraphFrames) + sizeof(scrollerFrames)	},
+		{	memoryShiftRegister,		sizeof(_shiftRegister),					0										},
+		{	memoryOutputFrame,			sizeof(_outputFrame),					0										},
+		{	memoryScheduler,			sizeof(_scheduler),						0										},
+		{	memoryBatteryMonitor,		sizeof(_batteryMonitor),				0										},
+		{	memoryInputs,				sizeof(_inputs),						0										},
+		{	memoryOverload,				sizeof(_overload),						0										},
+		{	memoryAnimation,			sizeof(_animation),						lightSequenceBytes						},
+		{	memoryAudioPulses,			sizeof(_audioPulses),					0										},
+		{	memoryAudioSerial,			sizeof(_audioSerial) + sizeof(_vsUart),	0										},
+		#if useAudioSerial
+			{	memoryAudioQueue,		sizeof(_audioQueue),					sizeof(audioFileOn) + sizeof(audioFileStateChange) + sizeof(audioFileOverload)	},
+		#endif
+		#if useLoopStatistics
+			{	memoryLoopStatistics,	sizeof(_loopStatistics),				0										},
+		#endif
+		{	memoryMemoryReport,			sizeof(_memoryReport),					0										},
+		{	memoryLog,					Log::staticBytes,						0										},
+		#if useTrace
+			{	memoryTrace,			Trace::staticBytes,						0										},
+		#endif
+		{	memoryInterrupts,			nInterruptBytes,						0										},
+		{	memoryOutputMap,			sizeof(Profile::outputs),				0										},
+		{	memoryArduino,				nArduinoCoreBytes,						0										}
+	};
+#endif
+
+template<typename Profile>
+NaquadahGenerator<Profile>::NaquadahGenerator() :
+	_shiftRegister(Profile::shiftRegisterDataPin, Profile::shiftRegisterClockPin, Profile::shiftRegisterLatchPin),
+	_outputFrame(&_shiftRegister),
+	_batteryMeterOn(false),
+	_batteryMonitor(Profile::batteryMeterSensePin, Profile::batteryMinReading, Profile::batteryMaxReading, Profile::batteryLowCharge, Profile::batteryLowHysteresis),
+	_batteryWarningOn(false),
+	_batteryWarningLightOn(false),
+	_modeButtonCount(0),
+	_modeButtonValue(GENERATOR::SPECIALMODEOFF),
+	_inputs(readInputs),
+	_lastInputs(0),
 	_generatorState(GENERATOR::STATE::OFF),
 	_currentBlueLight(0),
-	_lightDelay(_configuration->blueLightStandardDelay),
-	_audioSerial(_configuration->rxFromAudioTxPin, _configuration->txToAudioRxPin),
-	_vsUart(&_audioSerial, _configuration->audioResetPin)
+	_lightDelay(Profile::blueLightStandardDelay),
+	_animation(&_scheduler, SCHEDULER::ANIMATION),
+	_audioPulses(&_scheduler, SCHEDULER::AUDIOPULSES),
+	_audioSerial(Profile::rxFromAudioTxPin, Profile::txToAudioRxPin),
+	_vsUart(&_audioSerial, Profile::audioResetPin),
+	#if useAudioSerial
+		_audioQueue(&_audioSerial),
+	#endif
+	_transitionHook(nullptr)
+	#if useMemoryReport
+		, _memoryReport(_memoryComponents, sizeof(_memoryComponents) / sizeof(MemoryComponent))
+	#endif
 {
 }
 
-NaquadahGenerator::~NaquadahGenerator()
+template<typename Profile>
+NaquadahGenerator<Profile>::~NaquadahGenerator()
 {
 }
 
-void NaquadahGenerator::begin()
+template<typename Profile>
+void NaquadahGenerator<Profile>::begin()
 {
+	#if useMemoryReport
+		_memoryReport.begin();
+	#endif
+
 	// Initialize ready light input pin.
-	pinMode(_configuration->readyIndicatorPin, OUTPUT);
+	ReadyIndicatorPin::begin();
 
 	// We are going to do some work, so make sure the "ready" indicator light is off.
 	readyIndicatorLightOff();
 
-	_shiftRegister.set(AUDIO::UG, HIGH);
-	_shiftRegister.set(AUDIO::RESET, HIGH);
-	_shiftRegister.set(AUDIO::STATECHANGE, HIGH);
-	_shiftRegister.set(AUDIO::ON, HIGH);
+	// The board starts in UART mode if UG is low when it comes out of reset and in trigger mode otherwise.
+	_outputFrame.set(AUDIO::UG, useAudioSerial ? LOW : HIGH);
+	_outputFrame.set(AUDIO::RESET, HIGH);
+	_outputFrame.set(AUDIO::STATECHANGE, HIGH);
+	_outputFrame.set(AUDIO::ON, HIGH);
+	#if useOverloadTrigger
+		_outputFrame.set(AUDIO::OVERLOAD, HIGH);
+	#endif
+
+	// Light sequences are timed in beats of the start up delay.
+	_animation.setBeat(Profile::startUpDelay);
+	_animation.setSyncTimeout(Profile::audioSyncTimeout);
+
+	// The overload ramp is critical at the highest overload level.
+	_overload.begin(Profile::overloadCurve, Profile::overloadRampSteps, getOverloadDelay(GENERATOR::NUMBEROFSPECIALMODES-1));
+
+	// Limit the lights to the maximum brightness.
+	setLightBrightness(Profile::maximumBrightness);
+
+	// Send the audio trigger levels out before the audio board is started.
+	_outputFrame.commit();
+	_outputFrame.begin();
+
+	#if useLoopStatistics && useBrightnessEngine
+		_loopStatistics.setBrightnessEngine(_outputFrame.getBrightnessEngine());
+	#endif
 
 	// Audio set up.
 	// Set up the levels we want to use.
@@ -67,334 +177,508 @@ void NaquadahGenerator::begin()
 	_audioSerial.begin(9600);
 	_vsUart.begin();
 
+	#if useAudioSerial
+		_audioQueue.begin(Profile::audioReplyTimeout, Profile::audioSerialByteDelay);
+	#endif
+
 	// Battery meter initialization.
 	initializeBatteryMeter();
 		
-	// Set all the state pins as input.
-	for (int i = 0; i < GENERATOR::NUMBEROFSTATES; i++)
-	{
-		// Set as input (read from them).
-		pinMode(_configuration->stateInputPins[i], INPUT);
-		
-		// Use internal resistor to pull pin to high.  They are pulled low to indicate activation.
-		digitalWrite(_configuration->stateInputPins[i], HIGH);
-	}
+	// Initial state.  Just to make sure.
+	setGeneratorState(GENERATOR::OFF);
 
-	// Run startup sequence.  A light display just for the fun of it.
-	if (_configuration->runStartUpSequence)
+	// Start watching the state pins and buttons.  Use internal resistor to pull the pins to high.  They are pulled low to
+	// indicate activation.  If the arm is not in the off position, the first debounced sample reports it and the state is
+	// changed from update.
+	StatePins::begin();
+	ModeButtonPin::begin();
+	BatteryMeterButtonPin::begin();
+	_inputs.begin();
+
+	// The battery is measured in the background, the conversions are started by the sample interrupt.  The readings are
+	// picked up about as often as a new one is ready.
+	_batteryMonitor.begin();
+	_scheduler.start(SCHEDULER::BATTERYSAMPLE, batteryReadingPeriod, batteryReadingPeriod);
+
+	#if useTrace
+		Trace::begin();
+	#endif
+
+	// Run startup sequence.  A light display just for the fun of it.  The sequence is played from update, so the
+	// "ready" indicator is turned on as its last step.  Moving the arm cancels the sequence and also turns it on.
+	if (Profile::runStartUpSequence)
 	{
+		readyIndicatorLightOff();
 		startupSequence();
 	}
+	else
+	{
+		// All ready, turn on "ready" indicator light.
+		readyIndicatorLightOn();
+	}
 
-	// Initial state.  Just to make sure.
-	setGeneratorState(GENERATOR::OFF);
-
-	// All ready, turn on "ready" indicator light.
-	readyIndicatorLightOn();
+	_outputFrame.commit();
 
 	// If we are debugging, print that we are ready.
-	debugPrintLn("Generator state initialized.", DEBUG::STANDARD);
+	logPrintLn(DEBUG::STANDARD, F("Generator state initialized."));
 }
 
 // This is the main loop.  We keep it at light as possible by only updating when necessary.
-void NaquadahGenerator::update()
+template<typename Profile>
+void NaquadahGenerator<Profile>::update()
 {
-	// Check the current state.
-	GENERATOR::STATE newState = getGeneratorState();
-
-	// If the current state is different than the set one, we update everything.  Otherwise, we don't update to save time.
-	if (newState != _generatorState)
+	#if useLoopStatistics
+		unsigned long startTime = HAL::micros();
+	#endif
+
+	// Check for changes of the state sensors and buttons.  They are captured and debounced by an interrupt, so nothing is
+	// read unless an input changed.  Every change is handled in order so a quick pass through a position is not missed.
+	// Boards without the sample interrupt run it from here.
+	HAL::pollSampleInterrupt();
+
+	bool		inputsChanged = false;
+	InputEdge	edge;
+	while (_inputs.read(edge))
 	{
-		setGeneratorState(newState);
-	}
+		uint8_t changed	= edge.inputs ^ _lastInputs;
+		_lastInputs		= edge.inputs;
+		inputsChanged	= true;
 
-	// The setGeneratorState function will configure everything when the state changes.  Now we have to handle
-	// the events that need to be updated every loop.
-	switch (_generatorState)
-	{
-		case GENERATOR::OFF:
+		// Count presses of the mode button.  The count is picked up by the tick of the state.
+		if (changed & edge.inputs & (1 << INPUTBIT::MODEBUTTON))
+		{
+			_modeButtonCount = _modeButtonCount == GENERATOR::NUMBEROFSPECIALMODES-1 ? 0 : _modeButtonCount + 1;
+		}
+
+		if (changed & INPUTBIT::SENSORMASK)
 		{
-			GENERATOR::SPECIALMODE modeButtonValue = (GENERATOR::SPECIALMODE)_modeButton.getValue();
+			traceEventAt(TRACE::INPUTEDGE, edge.inputs & INPUTBIT::SENSORMASK, edge.time);
+			GENERATOR::STATE newState = getGeneratorState(edge.inputs);
 
-			if (modeButtonValue != _modeButtonValue)
+			// If the current state is different than the set one, we update everything.  Otherwise, we don't update to save time.
+			if (newState != _generatorState)
 			{
-				setSpecialMode(modeButtonValue);
+				setGeneratorState(newState);
 			}
-
-			runSpecialMode();
-			break;
 		}
+	}
+
+	// The setGeneratorState function will configure everything when the state changes.  The tick handlers only look at
+	// the buttons, the light sequence, and the battery meter timer, so they only run when one of those changed.  A press
+	// is handled before the timers, so a new overload level is used by a blue light step due in the same pass.
+	if (inputsChanged)
+	{
+		runHandler(&_stateHandlers[_generatorState].tick);
+	}
+
+	// Run whatever has come due: light sequence steps, audio trigger releases, blue light steps, and the battery.  When
+	// nothing is due, this is a single comparison with the earliest deadline.
+	if (runTimers())
+	{
+		runHandler(&_stateHandlers[_generatorState].tick);
+	}
+
+	// Everything above only staged its changes to the lights and audio triggers.  Send them all out at once.
+	bool latched = _outputFrame.commit();
 
-		case GENERATOR::PRIMED0:
-		case GENERATOR::PRIMED1:
+	// Sending a byte to the audio board blocks for its transmission time, so it waits until the lights are out.  Light
+	// cues waiting for a sound are timed from when the board said it started, not from when it was noticed.
+	#if useAudioSerial
+		_audioQueue.update();
+
+		unsigned long audioStartTime;
+		if (_audioQueue.getStart(audioStartTime))
 		{
-			break;
+			_animation.setAudioStart(audioStartTime + Profile::audioStartLatency);
 		}
-		
-		case GENERATOR::ON:
+	#endif
+
+	// Send out some of any debugging messages that are waiting.
+	if (debugLevel > DEBUG::OFF)
+	{
+		runDebugCommands();
+
+		#if useTrace
+			Trace::update();
+		#endif
+
+		#if useLoopStatistics
+			_loopStatistics.update();
+		#endif
+
+		#if useMemoryReport
+			_memoryReport.update();
+		#endif
+
+		Log::update();
+	}
+
+	#if useLoopStatistics
+		if (latched)
 		{
-			// Look to see if the mode button has been used to change the blue light timing.  This is how we implement "overload" timing of
-			// the lights.  The more you press the button, the faster the lights go, until the maximum value is hit.  After which, the light
-			// timing will reset (because the value return by getValue resets to zero).
-			//
-			// The value is updated with every loop to make sure we capture a button push.  The user won't see an effect until the timer times
-			// out and the lights update with the new timing value.
-			_modeButtonValue = (GENERATOR::SPECIALMODE)_modeButton.getValue();
-
-			// If in the on or overload state we need to be updating the current blue light, but only if we have
-			// passed the elapsed time.  The timer gets reset as part of the increment function.
-			if (_lightTimer.hasTimedOut())
-			{
-				_lightDelay = _configuration->blueLightStandardDelay - _modeButtonValue*_configuration->blueLightOverloadIncrement;
-				incrementCurrentBlueLight();
-			}
-			break;
+			_loopStatistics.recordLatch();
 		}
-
-		default:
+		_loopStatistics.recordLoop(HAL::micros() - startTime);
+	#else
+		(void)latched;
+	#endif
+
+	// Nothing can come due before the next interrupt (see useIdleSleep), so sleep until then.  The exception is an audio
+	// command part way out, whose next byte can go right away.
+	#if useIdleSleep
+		#if useAudioSerial
+			if (_audioQueue.getState() != AUDIOCOMMAND::SENDING)
+		#endif
 		{
-			// Error.
-			debugPrint("Error in update, invalid state reached.", DEBUG::STANDARD);
-			break;
+			sleep();
 		}
-	}
+	#endif
 }
 
-Configuration* NaquadahGenerator::getConfiguration()
+template<typename Profile>
+void NaquadahGenerator<Profile>::setTransitionHook(TransitionHook hook)
 {
-	return _configuration;
+	_transitionHook = hook;
 }
 
-void NaquadahGenerator::readyIndicatorLightOn()
+template<typename Profile>
+void NaquadahGenerator<Profile>::readyIndicatorLightOn()
 {
-	digitalWrite(_configuration->readyIndicatorPin, LIGHT::ON);
+	ReadyIndicatorPin::write(LIGHT::ON);
 }
 
-void NaquadahGenerator::readyIndicatorLightOff()
+template<typename Profile>
+void NaquadahGenerator<Profile>::readyIndicatorLightOff()
 {
-	digitalWrite(_configuration->readyIndicatorPin, LIGHT::OFF);
+	ReadyIndicatorPin::write(LIGHT::OFF);
 }
 
-void NaquadahGenerator::greenLightsOn()
+template<typename Profile>
+void NaquadahGenerator<Profile>::greenLightsOn()
 {
-	_shiftRegister.set(LIGHT::GREEN, LIGHT::ON);
+	_outputFrame.set(LIGHT::GREEN, LIGHT::ON);
 }
 
-void NaquadahGenerator::greenLightsOff()
+template<typename Profile>
+void NaquadahGenerator<Profile>::greenLightsOff()
 {
-	_shiftRegister.set(LIGHT::GREEN, LIGHT::OFF);
+	_outputFrame.set(LIGHT::GREEN, LIGHT::OFF);
 }
 
-void NaquadahGenerator::redLightsOn()
+template<typename Profile>
+void NaquadahGenerator<Profile>::redLightsOn()
 {
-	_shiftRegister.set(LIGHT::RED, LIGHT::ON);
+	_outputFrame.set(LIGHT::RED, LIGHT::ON);
 }
 
-void NaquadahGenerator::redLightsOff()
+template<typename Profile>
+void NaquadahGenerator<Profile>::redLightsOff()
 {
-	_shiftRegister.set(LIGHT::RED, LIGHT::OFF);
+	_outputFrame.set(LIGHT::RED, LIGHT::OFF);
 }
 
-void NaquadahGenerator::whiteLightsOn()
+template<typename Profile>
+void NaquadahGenerator<Profile>::whiteLightsOn()
 {
-	_shiftRegister.set(LIGHT::WHITE, LIGHT::ON);
+	_outputFrame.set(LIGHT::WHITE, LIGHT::ON);
 }
 
-void NaquadahGenerator::whiteLightsOff()
+template<typename Profile>
+void NaquadahGenerator<Profile>::whiteLightsOff()
 {
-	_shiftRegister.set(LIGHT::WHITE, LIGHT::OFF);
+	_outputFrame.set(LIGHT::WHITE, LIGHT::OFF);
 }
 
-void NaquadahGenerator::blueLightsOn(unsigned int numberOfLights)
+template<typename Profile>
+void NaquadahGenerator<Profile>::blueLightsOn(unsigned int numberOfLights)
 {
-	// Number of lights provided has to be between 1 and 5.
-	int lastOnLight = LIGHT::BLUE1 + numberOfLights - 1;
-
-	// First set the state for each light.  We don't need to update every
-	// time through the loop, so we use the no update version.
-	// Set the "on" values.
-	for (int i = LIGHT::BLUE1; i <= lastOnLight; i++)
+	// Number of lights provided has to be between 0 and 5.
+	if (numberOfLights > LIGHT::NUMBEROFBLUELIGHTS)
 	{
-		_shiftRegister.setNoUpdate(i, LIGHT::ON);
-	}
-	// Set the "off" values.
-	for (int i = lastOnLight + 1; i <= LIGHT::BLUE5; i++)
-	{
-		_shiftRegister.setNoUpdate(i, LIGHT::OFF);
+		numberOfLights = LIGHT::NUMBEROFBLUELIGHTS;
 	}
 
-	// The states have been set, so call update now to do the update all at once.
-	_shiftRegister.updateRegisters();
+	_outputFrame.setMasked(Profile::blueLightMask, HAL::readProgramMemory(&barGraphFrames[numberOfLights]) << Profile::firstBlueLightOutput);
 }
 
-void NaquadahGenerator::blueLightsOff()
+template<typename Profile>
+void NaquadahGenerator<Profile>::blueLightsOff()
 {
-	for (int i = LIGHT::BLUE1; i <= LIGHT::BLUE5; i++)
-	{
-		// First set the state for each light.  We don't need to update every
-		// time through the loop, so we use the no update version.
-		_shiftRegister.setNoUpdate(i, LIGHT::OFF);
-	}
-
-	// The states have been set, so call update now to do the update all at once.
-	_shiftRegister.updateRegisters();
+	_outputFrame.setMasked(Profile::blueLightMask, 0);
 }
 
-// This does the main work of scrolling the blue lights.  If the lights are on, the current
-// light is turned off and the next one turned on.  If the blue lights are off, a reset is done.
-void NaquadahGenerator::incrementCurrentBlueLight()
+// This does the main work of scrolling the blue lights.  The current light is turned off and the one "steps" lights
+// further on is turned on, wrapping around after the last light.
+template<typename Profile>
+void NaquadahGenerator<Profile>::incrementCurrentBlueLight(uint8_t steps)
 {
-	// All lights off (start with a clean slate).
-	_shiftRegister.setNoUpdate(_currentBlueLight, LIGHT::OFF);
-
 	// Increment the light.
 	// If we are  the last light, reset to the first.
-	if (_currentBlueLight == LIGHT::BLUE5)
-	{
-		_currentBlueLight = LIGHT::BLUE1;
-	}
-	else
-	{
-		_currentBlueLight++;
-	}
+	uint8_t position	= (_currentBlueLight - LIGHT::BLUE1 + steps) % LIGHT::NUMBEROFBLUELIGHTS;
+	_currentBlueLight	= LIGHT::BLUE1 + position;
 
-	_shiftRegister.set(_currentBlueLight, LIGHT::ON);
-
-	_lightTimer.setTimeOutTime(_lightDelay);
-	_lightTimer.reset();
+	// The new light on and all the others off.
+	_outputFrame.setMasked(Profile::blueLightMask, HAL::readProgramMemory(&scrollerFrames[position]) << Profile::firstBlueLightOutput);
+	traceEvent(TRACE::BLUELIGHT, _currentBlueLight);
 }
 
-void NaquadahGenerator::allLightsOff()
+template<typename Profile>
+void NaquadahGenerator<Profile>::allLightsOff()
 {
-	greenLightsOff();
-	redLightsOff();
-	whiteLightsOff();
-	blueLightsOff();
+	_outputFrame.setMasked(Profile::allLightsMask, 0);
 	readyIndicatorLightOn();
 }
 
-void NaquadahGenerator::blinkBlueLights(unsigned int numberOfLights)
+template<typename Profile>
+void NaquadahGenerator<Profile>::setLightBrightness(uint8_t brightness)
 {
-	// This is to allow numbers more than 5 to be displayed.  Since we only have 5 blue lights,
-	// we will blink 5 plus the remainder.  I.e., roller over means for than 5.
-	bool rolledOver = false;
+	if (brightness > Profile::maximumBrightness)
+	{
+		brightness = Profile::maximumBrightness;
+	}
 
-	unsigned int lightDelay = _configuration->startUpDelay;
+	for (int i = LIGHT::RED; i <= LIGHT::READY; i++)
+	{
+		_outputFrame.setBrightness(i, brightness);
+	}
+}
 
+template<typename Profile>
+void NaquadahGenerator<Profile>::blinkBlueLights(unsigned int numberOfLights)
+{
+	// This is to allow numbers more than 5 to be displayed.  Since we only have 5 blue lights,
+	// we will blink 5 plus the remainder.  I.e., roller over means for than 5.
 	if (numberOfLights > 5)
 	{
-		rolledOver		= true;
-		numberOfLights	= numberOfLights - 5;
+		_animation.play(sequenceBlinkBlueLightsRolledOver, numberOfLights - 5);
 	}
-
-	for (int i = 0; i < 3; i++)
+	else
 	{
-		if (rolledOver)
-		{
-			// All five blue lights on to show the first 5.
-			blueLightsOn(5);
+		_animation.play(sequenceBlinkBlueLights, numberOfLights);
+	}
+}
 
-			// Use a short dely to more closely associate the remainder with the first 5.  A longer
-			// delay is used between the groups.
-			delay(lightDelay);
-		}
+template<typename Profile>
+void NaquadahGenerator<Profile>::rampBlueLightsOn()
+{
+	_animation.play(sequenceRampBlueLightsOn);
+}
 
-		delay(lightDelay);
-		blueLightsOn(numberOfLights);
-		delay(lightDelay);
-		blueLightsOff();
-	}
+template<typename Profile>
+void NaquadahGenerator<Profile>::rampBlueLightsOff()
+{
+	_animation.play(sequenceRampBlueLightsOff);
 }
 
-void NaquadahGenerator::rampBlueLightsOn(unsigned int delayBetweenLights)
+template<typename Profile>
+void NaquadahGenerator<Profile>::rampUpAllLights()
 {
-	// Forwards on the blue lights.
-	for (int i = LIGHT::BLUE1; i <= LIGHT::BLUE5; i++)
+	_animation.play(sequenceRampUpAllLights);
+}
+
+template<typename Profile>
+void NaquadahGenerator<Profile>::rampDownAllLights()
+{
+	_animation.play(sequenceRampDownAllLights);
+}
+
+// Do a cool startup.
+template<typename Profile>
+void NaquadahGenerator<Profile>::startupSequence()
+{
+	_animation.play(sequenceStartUp);
+}
+
+template<typename Profile>
+void NaquadahGenerator<Profile>::stopSequence()
+{
+	// Some sequences (StartUp, RampUpMode) turn the "ready" indicator off until their last step, so it is turned back on
+	// when one of them is cut short.
+	if (_animation.isRunning())
 	{
-		delay(delayBetweenLights);
-		_shiftRegister.set(i, LIGHT::ON);
+		readyIndicatorLightOn();
 	}
+
+	_animation.clear();
 }
 
-void NaquadahGenerator::rampBlueLightsOff(unsigned int delayBetweenLights)
+// Applies all the keyframes that have come due since the last loop.
+template<typename Profile>
+void NaquadahGenerator<Profile>::runAnimation()
 {
-	for (int i = LIGHT::BLUE5; i >= LIGHT::BLUE1 ; i--)
+	Keyframe keyframe;
+
+	while (_animation.getNextKeyframe(keyframe))
 	{
-		delay(delayBetweenLights);
-		_shiftRegister.set(i, LIGHT::OFF);
+		applyKeyframe(keyframe);
 	}
 }
 
-void NaquadahGenerator::rampUpAllLights()
+template<typename Profile>
+void NaquadahGenerator<Profile>::applyKeyframe(const Keyframe& keyframe)
 {
-	// Forwards on the blue lights.
-	rampBlueLightsOn(_configuration->startUpDelay);
+	switch (keyframe.action)
+	{
+		case ANIMATION::WAIT:
+		{
+			break;
+		}
 
-	delay(2*_configuration->startUpDelay);
-	greenLightsOn();
+		case ANIMATION::LIGHTON:
+		{
+			_outputFrame.set(keyframe.value, LIGHT::ON);
+			break;
+		}
 
-	// This function is only used when in the "Off" mode.  In this mode, the handle is covering the red
-	// lights, so there is no reason to turn them on.  Save power by leaving them off.
-	//redLightsOn();
+		case ANIMATION::LIGHTOFF:
+		{
+			_outputFrame.set(keyframe.value, LIGHT::OFF);
+			break;
+		}
 
-	delay(2*_configuration->startUpDelay);
-	whiteLightsOn();
-}
+		case ANIMATION::BLUELIGHTSON:
+		{
+			blueLightsOn(keyframe.value);
+			break;
+		}
 
-void NaquadahGenerator::rampDownAllLights()
-{
-	whiteLightsOff();
+		case ANIMATION::BLUELIGHTSOFF:
+		{
+			blueLightsOff();
+			break;
+		}
+
+		case ANIMATION::READYON:
+		{
+			readyIndicatorLightOn();
+			break;
+		}
 
-	delay(2*_configuration->startUpDelay);
-	greenLightsOff();
-	redLightsOff();
+		case ANIMATION::READYOFF:
+		{
+			readyIndicatorLightOff();
+			break;
+		}
 
-	// Backwards on the blue lights.
-	delay(_configuration->startUpDelay);
-	rampBlueLightsOff(_configuration->startUpDelay);
+		case ANIMATION::BATTERYMETER:
+		{
+			updateBatteryMeter(true);
+			break;
+		}
+
+		case ANIMATION::BRIGHTNESS:
+		{
+			setLightBrightness(keyframe.value);
+			break;
+		}
+
+		case ANIMATION::AUDIOTRIGGER:
+		{
+			triggerAudio(keyframe.value);
+			break;
+		}
+
+		default:
+		{
+			break;
+		}
+	}
 }
 
-// Do a cool startup.
-void NaquadahGenerator::startupSequence()
+template<typename Profile>
+void NaquadahGenerator<Profile>::initializeBatteryMeter()
 {
-	rampUpAllLights();
+	// The battery meter has a timer to prevent flickering of the lights.
+	_scheduler.cancel(SCHEDULER::BATTERYMETER);
+	_batteryMeterOn = false;
+}
 
-	// Pause with all the lights on.
-	delay(12*_configuration->startUpDelay);
+// The battery level is shown on the blue lights while the activation button is pressed.  The lights are only changed
+// when the timer times out, unless "now" is specified.
+template<typename Profile>
+void NaquadahGenerator<Profile>::updateBatteryMeter(bool now)
+{
+	if (!(_lastInputs & (1 << INPUTBIT::BATTERYMETERBUTTON)))
+	{
+		if (_batteryMeterOn)
+		{
+			blueLightsOff();
+			_batteryMeterOn = false;
+			_scheduler.cancel(SCHEDULER::BATTERYMETER);
+		}
+		return;
+	}
 
-	rampDownAllLights();
+	if (now || !_batteryMeterOn || !_scheduler.isRunning(SCHEDULER::BATTERYMETER))
+	{
+		blueLightsOn(_batteryMonitor.getLevel());
+		_batteryMeterOn = true;
+		_scheduler.start(SCHEDULER::BATTERYMETER, Profile::batteryMeterUpdateDelay);
+	}
 }
 
-void NaquadahGenerator::initializeBatteryMeter()
+template<typename Profile>
+void NaquadahGenerator<Profile>::updateBatteryWarning()
 {
-	// This is the pin that is connected to the battery positive termina.
-	_batteryMeter.setSensingPin(_configuration->batteryMeterSensePin);
+	_batteryMonitor.update();
 
-	// These are the pins that the lights are connected to.
-	unsigned int switchRegisterBlueLightPins[] = {LIGHT::BLUE1, LIGHT::BLUE2, LIGHT::BLUE3, LIGHT::BLUE4, LIGHT::BLUE5};
-	_batteryMeter.setLightPins(switchRegisterBlueLightPins, HIGH);
+	if (_batteryMonitor.isLow() != _batteryWarningOn)
+	{
+		_batteryWarningOn = _batteryMonitor.isLow();
 
-	// This is the pin used to indicate when the battery meter should run.
-	_batteryMeter.setActivationButton(_batteryMeterButton);
+		if (_batteryWarningOn)
+		{
+			logPrintLn(DEBUG::STANDARD, F("Battery low."));
+			_scheduler.start(SCHEDULER::BATTERYWARNING, Profile::batteryWarningBlinkDelay, Profile::batteryWarningBlinkDelay);
+		}
+		else
+		{
+			_scheduler.cancel(SCHEDULER::BATTERYWARNING);
 
-	// Tell the battery meter to initialize.
-	_batteryMeter.begin();
+			if (!_animation.isRunning())
+			{
+				readyIndicatorLightOn();
+			}
+		}
+	}
 }
 
-void NaquadahGenerator::resetAll()
+template<typename Profile>
+void NaquadahGenerator<Profile>::blinkBatteryWarning()
+{
+	// Light sequences use the ready indicator too, so leave it to them while one is playing.
+	if (!_animation.isRunning())
+	{
+		_batteryWarningLightOn = !_batteryWarningLightOn;
+
+		if (_batteryWarningLightOn)
+		{
+			readyIndicatorLightOn();
+		}
+		else
+		{
+			readyIndicatorLightOff();
+		}
+	}
+}
+
+template<typename Profile>
+void NaquadahGenerator<Profile>::resetAll()
 {
 	resetLights();
 	resetControls();
 }
 
-void NaquadahGenerator::resetControls()
+template<typename Profile>
+void NaquadahGenerator<Profile>::resetControls()
 {
 	// Reset the toggle buttons so the initial state is active (off).
-	_modeButton.reset();
+	_modeButtonCount = 0;
 	_modeButtonValue = GENERATOR::SPECIALMODEOFF;  
 }
 
-void NaquadahGenerator::resetLights()
+template<typename Profile>
+void NaquadahGenerator<Profile>::resetLights()
 {
 	// Turn off all lights.
 	allLightsOff();
@@ -402,13 +686,21 @@ void NaquadahGenerator::resetLights()
 	// We always want to start with standard delay.  Overload can only be created by first turning to ON, then
 	// pressing the overload button.  We set the current blue light to 5 because we are going to call "increment"
 	// to turn them on and increment with update to BLUE1 before turning on the light.
-	_lightDelay       = _configuration->blueLightStandardDelay;
+	_lightDelay       = Profile::blueLightStandardDelay;
 	_currentBlueLight = LIGHT::BLUE5;
+	_overload.reset(_lightDelay);
+}
+
+template<typename Profile>
+uint8_t NaquadahGenerator<Profile>::readInputs()
+{
+	return StatePins::readActive() | (ModeButtonPin::readActive() << INPUTBIT::MODEBUTTON) | (BatteryMeterButtonPin::readActive() << INPUTBIT::BATTERYMETERBUTTON);
 }
 
-GENERATOR::STATE NaquadahGenerator::getGeneratorState()
+template<typename Profile>
+GENERATOR::STATE NaquadahGenerator<Profile>::getGeneratorState(uint8_t inputs)
 {
-	// This function reads the state sensing pins and determines what the current state is.  This function must NOT set
+	// This function takes the state sensing inputs and determines what the current state is.  This function must NOT set
 	// the value of the member variable (_generatorState).  That gets done in the setGeneratorState function.  Separating
 	// out the two lets us determine if we actually need to change the state (if it stays the same, we do nothing).
 
@@ -420,7 +712,7 @@ GENERATOR::STATE NaquadahGenerator::getGeneratorState()
 	// Start by finding the base state specified by when one of the Cap position sensors goes active.
 	for (int i =  GENERATOR::OFF; i < GENERATOR::NUMBEROFSTATES; i++)
 	{
-		if (digitalRead(_configuration->stateInputPins[i]) == LOW)
+		if (inputs & (1 << i))
 		{
 			// We found the activated sensor, save it and break from the loop.
 			generatorState  = (GENERATOR::STATE)i;
@@ -428,228 +720,499 @@ GENERATOR::STATE NaquadahGenerator::getGeneratorState()
 		}
 	}
 
-	debugPrint("Generator state: ", DEBUG::VERBOSE);
-	debugPrintLn(generatorState, DEBUG::VERBOSE);
+	logPrint(DEBUG::VERBOSE, F("Generator state: "));
+	logPrintLn(DEBUG::VERBOSE, generatorState);
 
 	return generatorState;
 }
 
-void NaquadahGenerator::setGeneratorState(GENERATOR::STATE state)
+template<typename Profile>
+void NaquadahGenerator<Profile>::setGeneratorState(GENERATOR::STATE state)
 {
+	GENERATOR::STATE previousState	= _generatorState;
+	unsigned long startTime			= HAL::micros();
+
+	runHandler(&_stateHandlers[previousState].exit);
+
 	// Update our state.
 	_generatorState = state;
+	traceEvent(TRACE::STATECHANGE, _generatorState);
 
-	// The state changes when a hall sensor is trigger, we want to make a sound to go with this event.
-	// bool playResult = _vsUart.playFile("STATECHGOGG");
-	// debugPrint("State change play: ", DEBUGLEVEL::STANDARD);
-	// debugPrintLn((int)playResult, DEBUGLEVEL::STANDARD)
-	_shiftRegister.set(AUDIO::ON, HIGH);
-	_shiftRegister.set(AUDIO::STATECHANGE, LOW);
-	
-	// For the case of switching between PRIMED1 and ON, we don't want to turn off the red lights then turn
-	// them back on.  Doing so might cause a flicker.  Therefore, we don't call reset when switching between
-	// those two.
-	switch (_generatorState)
+	// Moving the arm cancels any light sequence that is playing.
+	stopSequence();
+
+	// The state changes when a hall sensor is trigger, we want to make a sound to go with this event.  In trigger mode,
+	// the "on" sound is held by its trigger line, so release it first.  Over the serial port, the state change sound
+	// stops whatever is playing.
+	#if !useAudioSerial
+		_audioPulses.cancel(AUDIO::ON);
+		_outputFrame.set(AUDIO::ON, HIGH);
+	#endif
+	triggerAudio(AUDIO::STATECHANGE);
+
+	runHandler(&_stateHandlers[_generatorState].enter);
+
+	if (_transitionHook != nullptr)
 	{
-		case GENERATOR::OFF:
-		{
-			resetAll();
-			break;
-		}
-			
-		case GENERATOR::PRIMED0:
-		{
-			resetAll();
-			greenLightsOn();
-			break;
-		}
-			
-		case GENERATOR::PRIMED1:
-		{
-			greenLightsOff();
-			redLightsOn();
-			whiteLightsOff();
-			blueLightsOff();
+		_transitionHook(STATEMACHINE::GENERATORSTATE, previousState, _generatorState, HAL::micros() - startTime);
+	}
+}
 
-			resetControls();
-			break;
-		}
-			
-		case GENERATOR::ON:
-		{
-			greenLightsOff();
-			redLightsOn();
-			whiteLightsOn();
+template<typename Profile>
+void NaquadahGenerator<Profile>::setSpecialMode(GENERATOR::SPECIALMODE specialMode)
+{
+	logPrint(DEBUG::STANDARD, F("Previous mode: "));
+	logPrintLn(DEBUG::STANDARD, _modeButtonValue);
 
-			resetControls();
+	GENERATOR::SPECIALMODE previousMode	= _modeButtonValue;
+	unsigned long startTime				= HAL::micros();
 
-			// This will turn on the first light and start the timer.
-			incrementCurrentBlueLight();
+	runHandler(&_specialModeHandlers[previousMode].exit);
 
-			delay(120);
-			_shiftRegister.set(AUDIO::STATECHANGE, HIGH);
-			_shiftRegister.set(AUDIO::ON, LOW);
-			//_vsUart.playFile(F("NQHGENONOGG"));
-			break;
-		}
+	_modeButtonValue = specialMode;
+	traceEvent(TRACE::SPECIALMODE, _modeButtonValue);
+	stopSequence();
+	resetLights();
 
-		case GENERATOR::NUMBEROFSTATES:
-		{
-			debugPrint("Error in setGeneratorState, invalid state reached.", DEBUG::STANDARD);
-			break;
-		}
+	logPrint(DEBUG::STANDARD, F("Set special mode: "));
+	logPrintLn(DEBUG::STANDARD, _modeButtonValue);
+
+	// Display which special mode we are in by blinking the corresponding number of blue lights.  The blinking is played
+	// from update, so the display of the mode is played after it.
+	blinkBlueLights(_modeButtonValue);
+
+	const uint8_t* sequence = HAL::readProgramMemory(&_specialModeHandlers[_modeButtonValue].sequence);
+	if (sequence != nullptr)
+	{
+		_animation.play(sequence);
 	}
 
-	delay(120);
-	_shiftRegister.set(AUDIO::STATECHANGE, HIGH);
+	runHandler(&_specialModeHandlers[_modeButtonValue].enter);
+
+	if (_transitionHook != nullptr)
+	{
+		_transitionHook(STATEMACHINE::SPECIALMODE, previousMode, _modeButtonValue, HAL::micros() - startTime);
+	}
 }
 
-void NaquadahGenerator::setSpecialMode(GENERATOR::SPECIALMODE specialMode)
+template<typename Profile>
+void NaquadahGenerator<Profile>::runSpecialMode()
 {
-	debugPrint("Previous mode: ", DEBUG::STANDARD);
-	debugPrintLn(_modeButtonValue, DEBUG::STANDARD);
+	runHandler(&_specialModeHandlers[_modeButtonValue].tick);
+}
 
-	_modeButtonValue = specialMode;
-	resetLights();
+// The handler tables.  The rows must be in the same order as the GENERATOR::STATE and GENERATOR::SPECIALMODE enums.
+// The entry handlers run after the work common to every change (in setGeneratorState and setSpecialMode) is done.
+// The sequences (see LightSequences.txt) of the special modes are played once the mode number has been blinked.
+template<typename Profile>
+const typename NaquadahGenerator<Profile>::StateHandlers NaquadahGenerator<Profile>::_stateHandlers[GENERATOR::NUMBEROFSTATES] PROGMEM =
+{
+	//	Enter							Exit							Tick							Sequence
+	{	enterOff,						exitOff,						tickOff,						nullptr								},		// OFF
+	{	enterPrimed0,					nullptr,						nullptr,						nullptr								},		// PRIMED0
+	{	enterPrimed1,					nullptr,						nullptr,						nullptr								},		// PRIMED1
+	{	enterOn,						exitOn,							tickOn,							nullptr								}		// ON
+};
+
+template<typename Profile>
+const typename NaquadahGenerator<Profile>::StateHandlers NaquadahGenerator<Profile>::_specialModeHandlers[GENERATOR::NUMBEROFSPECIALMODES] PROGMEM =
+{
+	//	Enter							Exit							Tick							Sequence
+	{	nullptr,						nullptr,						nullptr,						nullptr								},		// SPECIALMODEOFF
+	{	nullptr,						exitBatteryMeterMode,			tickBatteryMeterMode,			sequenceBatteryMeterMode			},		// SPECIALMODE01
+	{	nullptr,						nullptr,						nullptr,						sequenceRampUpMode					},		// SPECIALMODE02
+	{	nullptr,						nullptr,						nullptr,						sequenceBlueLightsMode				},		// SPECIALMODE03
+	{	nullptr,						nullptr,						nullptr,						sequenceWhiteLightMode				},		// SPECIALMODE04
+	{	nullptr,						nullptr,						nullptr,						sequenceGreenAndRedLightsMode		},		// SPECIALMODE05
+	{	nullptr,						nullptr,						nullptr,						sequencePowerTestMode				}		// SPECIALMODE06
+};
+
+template<typename Profile>
+void NaquadahGenerator<Profile>::runHandler(const Handler* handler)
+{
+	Handler function = HAL::readProgramMemory(handler);
+
+	if (function != nullptr)
+	{
+		function(*this);
+	}
+}
 
-	debugPrint("Set special mode: ", DEBUG::STANDARD);
-	debugPrintLn(_modeButtonValue, DEBUG::STANDARD);
+template<typename Profile>
+void NaquadahGenerator<Profile>::enterOff(NaquadahGenerator& generator)
+{
+	generator.resetAll();
+}
 
-	// Display which special mode we are in by blinking the corresponding number of blue lights.
-	blinkBlueLights(_modeButtonValue);
+template<typename Profile>
+void NaquadahGenerator<Profile>::exitOff(NaquadahGenerator& generator)
+{
+	// The special modes only run in the off position.
+	generator.runHandler(&_specialModeHandlers[generator._modeButtonValue].exit);
+}
+
+template<typename Profile>
+void NaquadahGenerator<Profile>::tickOff(NaquadahGenerator& generator)
+{
+	GENERATOR::SPECIALMODE modeButtonValue = (GENERATOR::SPECIALMODE)generator._modeButtonCount;
 
-	switch (_modeButtonValue)
+	if (modeButtonValue != generator._modeButtonValue)
 	{
-		case GENERATOR::SPECIALMODEOFF:
-		{
-			break;
-		}
+		generator.setSpecialMode(modeButtonValue);
+	}
 
-		case GENERATOR::SPECIALMODE01:
-		{
-			// This is the battery meter mode.  The battery meter has a timer in it to prevent flickering of the lights.  The update only
-			// runs when the timer times out.  Normally, this works well, however we have a slightly different case.  We need to call
-			// updateNow here to turn the lights on immediately without waiting for the timer.  In runSpecialMode, changes in the battery
-			// level will be handled by the normal update function.
-			_batteryMeter.updateNow();
-			break;
-		}
+	generator.runSpecialMode();
+}
 
-		case GENERATOR::SPECIALMODE02:
-		{
-			readyIndicatorLightOff();
-			rampUpAllLights();
-			readyIndicatorLightOn();
-			break;
-		}
+template<typename Profile>
+void NaquadahGenerator<Profile>::enterPrimed0(NaquadahGenerator& generator)
+{
+	generator.resetAll();
+	generator.greenLightsOn();
+}
 
-		case GENERATOR::SPECIALMODE03:
-		{
-			blueLightsOn(5);
-			break;
-		}
+// For the case of switching between PRIMED1 and ON, we don't want to turn off the red lights then turn them back on.
+// Doing so might cause a flicker.  Therefore, we don't call reset when switching between those two.
+template<typename Profile>
+void NaquadahGenerator<Profile>::enterPrimed1(NaquadahGenerator& generator)
+{
+	generator.greenLightsOff();
+	generator.redLightsOn();
+	generator.whiteLightsOff();
+	generator.blueLightsOff();
 
-		case GENERATOR::SPECIALMODE04:
-		{
-			whiteLightsOn();
-			break;
-		}
+	generator.resetControls();
+}
 
-		case GENERATOR::SPECIALMODE05:
-		{
-			greenLightsOn();
-			redLightsOn();
-			break;
-		}
+template<typename Profile>
+void NaquadahGenerator<Profile>::enterOn(NaquadahGenerator& generator)
+{
+	generator.greenLightsOff();
+	generator.redLightsOn();
+	generator.whiteLightsOn();
+
+	// The mode button count was just reset, so the overload level goes back with it.  Coming from PRIMED1, the ramp could
+	// still be at the overload speed otherwise.
+	generator.resetControls();
+	generator._lightDelay = Profile::blueLightStandardDelay;
+	generator._overload.reset(generator._lightDelay);
+
+	// This will turn on the first light and start the timer.
+	generator.incrementCurrentBlueLight();
+	generator._lightTimer.start(generator._lightDelay);
+	generator._scheduler.schedule(SCHEDULER::LIGHTSTEP, generator._lightTimer.getDeadline());
+
+	// Start the "on" sound once the state change sound has been started (trigger mode) or has finished (serial port).
+	#if useAudioSerial
+		generator.triggerAudio(AUDIO::ON);
+	#else
+		generator._audioPulses.schedule(AUDIO::ON, LOW, Profile::audioTriggerDuration);
+	#endif
+}
 
-		case GENERATOR::SPECIALMODE06:
-		{
-			// Test mode only.  Used to test total power draw from all lights.
-			rampUpAllLights();
-			redLightsOn();
-			break;
-		}
+template<typename Profile>
+void NaquadahGenerator<Profile>::exitOn(NaquadahGenerator& generator)
+{
+	generator._scheduler.cancel(SCHEDULER::LIGHTSTEP);
+}
 
-		case GENERATOR::NUMBEROFSPECIALMODES:
-		{
-			// The last enum is used as a placeholder to determine the total number of enums in the series.  However, the
-			// Arduino IDE likes to complain when you don't handle all enums in the series so we use this to appease it.
-			debugPrint("Error in setSpecialMode, invalid state reached.", DEBUG::STANDARD);
-			break;
-		}
+template<typename Profile>
+void NaquadahGenerator<Profile>::tickOn(NaquadahGenerator& generator)
+{
+	// Look to see if the mode button has been used to change the blue light timing.  This is how we implement "overload" timing of
+	// the lights.  The more you press the button, the faster the lights go, until the maximum value is hit.  After which, the light
+	// timing will reset (because the button count wraps back to zero).
+	//
+	// The new level only sets the target of the overload ramp, the light delay is eased to it one blue light step at a time
+	// (see stepBlueLights).
+	GENERATOR::SPECIALMODE modeButtonValue = (GENERATOR::SPECIALMODE)generator._modeButtonCount;
+	if (modeButtonValue != generator._modeButtonValue)
+	{
+		generator._modeButtonValue = modeButtonValue;
+		generator._overload.setTarget(generator.getOverloadDelay(modeButtonValue));
 	}
 }
 
-void NaquadahGenerator::runSpecialMode()
+// This is the battery meter mode.  The battery meter has a timer in it to prevent flickering of the lights.  The update only
+// runs when the timer times out.  Normally, this works well, however we have a slightly different case.  We need to force
+// an update to turn the lights on immediately without waiting for the timer, which is done by the sequence of the mode.
+// In the tick handler, changes in the battery level will be handled by the normal update function.
+template<typename Profile>
+void NaquadahGenerator<Profile>::tickBatteryMeterMode(NaquadahGenerator& generator)
+{
+	// This checkes the metering button and updates the blue lights accordingly.  Wait until the mode number has
+	// finished blinking so the two don't fight over the blue lights.
+	if (!generator._animation.isRunning())
+	{
+		generator.updateBatteryMeter(false);
+	}
+}
+
+template<typename Profile>
+void NaquadahGenerator<Profile>::exitBatteryMeterMode(NaquadahGenerator& generator)
+{
+	generator.blueLightsOff();
+	generator.initializeBatteryMeter();
+}
+
+template<typename Profile>
+bool NaquadahGenerator<Profile>::runTimers()
 {
-	debugPrint("Run special mode: ", DEBUG::STANDARD);
-	debugPrintLn(_modeButtonValue, DEBUG::STANDARD);
+	bool	tick = false;
+	uint8_t	timer;
 
-	switch (_modeButtonValue)
+	while (_scheduler.getNextDue(timer))
 	{
-		case GENERATOR::SPECIALMODEOFF:
-		{
-			break;
-		}
+		#if useLoopStatistics
+			unsigned long startTime = HAL::micros();
+		#endif
 
-		case GENERATOR::SPECIALMODE01:
+		switch (timer)
 		{
-			// This checkes the metering button and updates the blue lights accordingly.
-			_batteryMeter.update();
-			break;
-		}
+			case SCHEDULER::ANIMATION:
+			{
+				// The battery meter mode waits for its sequence to finish.
+				runAnimation();
+				tick = true;
+				break;
+			}
 
-		case GENERATOR::SPECIALMODE02:
-		case GENERATOR::SPECIALMODE03:
-		case GENERATOR::SPECIALMODE04:
-		case GENERATOR::SPECIALMODE05:
-		case GENERATOR::SPECIALMODE06:
-		{
-			break;
-		}
+			case SCHEDULER::AUDIOPULSES:
+			{
+				runAudioPulses();
+				break;
+			}
 
-		case GENERATOR::NUMBEROFSPECIALMODES:
-		{
-			// The last enum is used as a placeholder to determine the total number of enums in the series.  However, the
-			// Arduino IDE likes to complain when you don't handle all enums in the series so we use this to appease it.
-			debugPrint("Error in runSpecialMode, invalid state reached.", DEBUG::STANDARD);
-			break;
+			case SCHEDULER::LIGHTSTEP:
+			{
+				stepBlueLights();
+				break;
+			}
+
+			case SCHEDULER::BATTERYMETER:
+			{
+				tick = true;
+				break;
+			}
+
+			case SCHEDULER::BATTERYSAMPLE:
+			{
+				updateBatteryWarning();
+				break;
+			}
+
+			case SCHEDULER::BATTERYWARNING:
+			{
+				blinkBatteryWarning();
+				break;
+			}
 		}
+
+		#if useLoopStatistics
+			_loopStatistics.recordDispatch(timer, HAL::micros() - startTime);
+		#endif
 	}
+
+	return tick;
 }
 
-void  NaquadahGenerator::triggerAudio()
+// In the on or overload state, the current blue light is moved on when the next step is due.  The timer keeps absolute
+// deadlines, so the scroll rate doesn't drift.  If the loop stalled past more than one step, the light jumps ahead by
+// the steps that were missed so it stays in phase.
+template<typename Profile>
+void NaquadahGenerator<Profile>::stepBlueLights()
 {
-}  
- 
-void NaquadahGenerator::debugPrint(const char message[], DEBUG::DEBUGLEVEL level)
-{
-	if (_configuration->DebugLevel >= level)
+	uint8_t steps = _lightTimer.update();
+	if (steps > 0)
 	{
-		Serial.print(message);
+		#if useLoopStatistics
+			_loopStatistics.recordLightStep(_lightTimer.getLateness());
+		#endif
+
+		OVERLOAD::PHASE previousPhase = _overload.getPhase();
+
+		_lightDelay = _overload.update();
+		_lightTimer.setPeriod(_lightDelay);
+		incrementCurrentBlueLight(steps);
+
+		if (_overload.getPhase() != previousPhase)
+		{
+			setOverloadPhase(previousPhase, _overload.getPhase());
+		}
 	}
+
+	_scheduler.schedule(SCHEDULER::LIGHTSTEP, _lightTimer.getDeadline());
 }
 
-void NaquadahGenerator::debugPrint(int message, DEBUG::DEBUGLEVEL level)
+template<typename Profile>
+void NaquadahGenerator<Profile>::runAudioPulses()
 {
-	if (_configuration->DebugLevel >= level)
+	uint8_t output;
+	uint8_t level;
+
+	while (_audioPulses.getNextChange(output, level))
 	{
-		Serial.print(message);
+		_outputFrame.set(output, level);
+		traceEvent(TRACE::AUDIOTRIGGER, output | level << 7);
 	}
 }
 
-void NaquadahGenerator::debugPrintLn(const char message[], DEBUG::DEBUGLEVEL level)
+template<typename Profile>
+unsigned int NaquadahGenerator<Profile>::getOverloadDelay(uint8_t level)
 {
-	if (_configuration->DebugLevel >= level)
+	return Profile::blueLightStandardDelay - level*Profile::blueLightOverloadIncrement;
+}
+
+template<typename Profile>
+void NaquadahGenerator<Profile>::setOverloadPhase(OVERLOAD::PHASE previousPhase, OVERLOAD::PHASE phase)
+{
+	traceEvent(TRACE::OVERLOADPHASE, phase);
+
+	// Reaching full overload plays its own sound, with the white light flashing in time.  Coming back down from it
+	// stops the flashing and starts the "on" sound again.  In trigger mode, the "on" trigger line is held active for the
+	// whole ON state, so it is put back to held rather than pulsed (a pulse would release it and stop the hum).
+	if (phase == OVERLOAD::CRITICAL)
 	{
-		Serial.println(message);
+		_animation.play(sequenceOverloadCritical);
 	}
+	else if (previousPhase == OVERLOAD::CRITICAL)
+	{
+		stopSequence();
+		whiteLightsOn();
+		#if useAudioSerial
+			triggerAudio(AUDIO::ON);
+		#else
+			traceEvent(TRACE::AUDIOTRIGGER, AUDIO::ON | LOW << 7);
+			_audioPulses.cancel(AUDIO::ON);
+			_outputFrame.set(AUDIO::ON, LOW);
+		#endif
+	}
+}
+
+template<typename Profile>
+void NaquadahGenerator<Profile>::sleep()
+{
+	#if useLoopStatistics
+		unsigned long startTime = HAL::micros();
+	#endif
+
+	HAL::sleep();
+
+	#if useLoopStatistics
+		_loopStatistics.recordSleep(HAL::micros() - startTime);
+	#endif
 }
 
-void NaquadahGenerator::debugPrintLn(int message, DEBUG::DEBUGLEVEL level)
+template<typename Profile>
+void NaquadahGenerator<Profile>::runDebugCommands()
 {
-	if (_configuration->DebugLevel >= level)
+	while (HAL::debugAvailable() > 0)
 	{
-		Serial.println(message);
+		switch (HAL::debugRead())
+		{
+			#if useTrace
+				case 't':
+				{
+					Trace::dump();
+					break;
+				}
+			#endif
+
+			#if useLoopStatistics
+				case 'l':
+				{
+					_loopStatistics.report();
+					break;
+				}
+
+				case 'c':
+				{
+					_loopStatistics.reset();
+					break;
+				}
+			#endif
+
+			#if useMemoryReport
+				case 'm':
+				{
+					_memoryReport.report();
+					break;
+				}
+			#endif
+
+			default:
+			{
+				break;
+			}
+		}
 	}
-}
\ No newline at end of file
+}
+
+// The audio triggers are active low.  The trigger is held low for a short time, then released from update by the pulse
+// scheduler.  Over the serial port, the file that goes with the trigger is queued instead.  The "on" sound is the hum,
+// which repeats until another sound stops it.
+template<typename Profile>
+void NaquadahGenerator<Profile>::triggerAudio(uint8_t trigger)
+{
+	#if !useAudioSerial
+		if (trigger == AUDIO::OVERLOAD)
+		{
+			trigger = Profile::overloadAudioTrigger;
+		}
+	#endif
+
+	traceEvent(TRACE::AUDIOTRIGGER, trigger | LOW << 7);
+
+	// In trigger mode, when the sound starts is known now.  Over the serial port, it is known when the board answers.
+	#if !useAudioSerial
+		_animation.setAudioStart(HAL::millis() + Profile::audioStartLatency);
+	#endif
+
+	#if useAudioSerial
+		switch (trigger)
+		{
+			case AUDIO::ON:
+			{
+				_audioQueue.play(audioFileOn, AUDIOCOMMAND::AMBIENT, true);
+				break;
+			}
+
+			case AUDIO::STATECHANGE:
+			{
+				_audioQueue.play(audioFileStateChange, AUDIOCOMMAND::STATECHANGE);
+				break;
+			}
+
+			case AUDIO::OVERLOAD:
+			{
+				_audioQueue.play(audioFileOverload, AUDIOCOMMAND::EFFECT);
+				break;
+			}
+
+			default:
+			{
+				break;
+			}
+		}
+	#else
+		_outputFrame.set(trigger, LOW);
+		_audioPulses.schedule(trigger, HIGH, Profile::audioTriggerDuration);
+	#endif
+}  
+ 
+
+// The profile that is built.  The simulator builds every profile, so a change that breaks one shows up whichever is
+// selected.  A new profile is added to its list.
+#if defined(ARDUINO)
+	template class NaquadahGenerator<Configuration>;
+#else
+	template class NaquadahGenerator<StandardProfile>;
+	template class NaquadahGenerator<LowPowerProfile>;
+#endif
+
+// The generator is allocated statically, so everything but the stack is known when it is compiled.  The RAM size is only
+// known when building for the board.  The Arduino core figure is counted by hand (see nArduinoCoreBytes), so this is an
+// estimate.  The data and bss sizes printed by the build are the real total.
+#if defined(RAMEND)
+	static_assert(sizeof(NaquadahGenerator<Configuration>) + sizeof(Configuration::outputs) + Log::staticBytes + useTrace*Trace::staticBytes + nInterruptBytes + nArduinoCoreBytes <= RAMEND - RAMSTART + 1 - nStackReserveBytes, "The static data doesn't leave the stack enough RAM (nStackReserveBytes).");
+#endif
@@ -18,26 +18,35 @@
 #ifndef NAQUADAHGENERATOR_H
 #define NAQUADAHGENERATOR_H
 
-#include <Arduino.h>
+#include "HardwareAbstraction.h"
 #include "enums.h"
-#include "configuration.h"
-#include "ShiftRegister74HC595.h"
-#include "BatteryMeterShiftRegister.h"
-#include "AlwaysOnButton.h"
-#include "CycleButton.h"
-#include "SoftTimers.h"
-#include "BlinkShiftRegister.h"
-#include "SoftwareSerial.h"
+#include "Configuration.h"
+#include "Scheduler.h"
+#include "DeadlineTimer.h"
+#include "OverloadRamp.h"
+#include "BatteryMonitor.h"
 #include "VS1000UART.h"
+#include "AudioQueue.h"
+#include "Animation.h"
+#include "PulseScheduler.h"
+#include "OutputFrame.h"
+#include "InputCapture.h"
+#include "FastPins.h"
+#include "Log.h"
+#include "Trace.h"
+#include "LoopStatistics.h"
+#include "MemoryReport.h"
 
 //#include "BlinkPin.h"
 
+// The generator is built for a profile (see Configuration.h), which has its settings and its wiring.
+template<typename Profile>
 class NaquadahGenerator
 {
 	// Constructors.
 	public:
 		// Default contstructor.
-		NaquadahGenerator(Configuration* configuration);
+		NaquadahGenerator();
 
 		// Default destructor.
 		~NaquadahGenerator();
@@ -50,9 +59,13 @@ class NaquadahGenerator
 		// Run this in the loop to update all the lights and controls.
 		void update();
 
-		Configuration* getConfiguration();
+		// Profiling hook.  Called after every generator state and special mode change with the time (microseconds) the
+		// exit and entry handlers took.  Set to nullptr (the default) to turn it off.
+		typedef void (*TransitionHook)(STATEMACHINE::MACHINE machine, uint8_t from, uint8_t to, unsigned long time);
+		void setTransitionHook(TransitionHook hook);
 
-	// Light control functions.
+	// Light control functions.  Changes to the shift register lights are staged and sent out at the end of the next
+	// update.
 	public:
 		// Standard on/off/increment (blue lights) lighting control functions.
 		void readyIndicatorLightOn();
@@ -69,62 +82,156 @@ class NaquadahGenerator
 
 		void blueLightsOn(unsigned int numberOfLights);
 		void blueLightsOff();
-		void incrementCurrentBlueLight();
+		void incrementCurrentBlueLight(uint8_t steps = 1);
 
 		void allLightsOff();
 
-		// Lights functions for sequences, special modes, et cetera.
+		// Brightness of all the shift register lights (0 to 2^brightnessBits - 1), limited to the configured maximum.
+		// Only has an effect when the brightness engine is turned on.
+		void setLightBrightness(uint8_t brightness);
+
+		// Lights functions for sequences, special modes, et cetera.  These do not block.  They add their sequence (see
+		// LightSequences.txt) to the light animation, which is played back from update.  Calling several in a row plays
+		// them one after the other.
 		void blinkBlueLights(unsigned int numberOfLights);
 
-		void rampBlueLightsOn(unsigned int delayBetweenLights);
-		void rampBlueLightsOff(unsigned int delayBetweenLights);
+		void rampBlueLightsOn();
+		void rampBlueLightsOff();
 
 		void rampUpAllLights();
 		void rampDownAllLights();
 
 		void startupSequence();
+
+		// Stop any light sequence that is playing.
+		void stopSequence();
 		
 	private:
 		// Initialization functions.
 		void initializeBatteryMeter();
 
+		// Battery meter.
+		void updateBatteryMeter(bool now);
+
+		// Filters the battery readings and starts or stops the low battery warning.
+		void updateBatteryWarning();
+
+		// Blinks the ready indicator while the battery is low.
+		void blinkBatteryWarning();
+
 		// Reset functions.
 		void resetAll();
 		void resetLights();
 		void resetControls();
 
 		// Generator state.
-		GENERATOR::STATE getGeneratorState();
+		GENERATOR::STATE getGeneratorState(uint8_t inputs);
 		void setGeneratorState(GENERATOR::STATE state);
 
 		void setSpecialMode(GENERATOR::SPECIALMODE specialMode);
 		void runSpecialMode();
 
-		// Audio.
-		void triggerAudio();
+		// State machines.  Each generator state and special mode has entry, exit, and tick handlers and a light sequence.
+		// The tick handlers run when an input changed or a light sequence or battery meter timer ran, not on every pass
+		// through the loop.  They are looked up in tables stored in flash, so adding a mode costs flash, not SRAM.
+		// Handlers and sequences that are not needed are nullptr.
+		typedef void (*Handler)(NaquadahGenerator& generator);
+
+		struct StateHandlers
+		{
+			Handler											enter;
+			Handler											exit;
+			Handler											tick;
+			const uint8_t*									sequence;
+		};
+
+		static const StateHandlers							_stateHandlers[GENERATOR::NUMBEROFSTATES];
+		static const StateHandlers							_specialModeHandlers[GENERATOR::NUMBEROFSPECIALMODES];
+
+		void runHandler(const Handler* handler);
+
+		// Generator state handlers.
+		static void enterOff(NaquadahGenerator& generator);
+		static void exitOff(NaquadahGenerator& generator);
+		static void tickOff(NaquadahGenerator& generator);
+		static void enterPrimed0(NaquadahGenerator& generator);
+		static void enterPrimed1(NaquadahGenerator& generator);
+		static void enterOn(NaquadahGenerator& generator);
+		static void exitOn(NaquadahGenerator& generator);
+		static void tickOn(NaquadahGenerator& generator);
+
+		// Special mode handlers.
+		static void tickBatteryMeterMode(NaquadahGenerator& generator);
+		static void exitBatteryMeterMode(NaquadahGenerator& generator);
+
+		// Runs the timers that are due.  Returns true if one the tick handlers wait on ran.
+		bool runTimers();
+
+		// Moves the scrolling blue light on by the steps that are due (ON state).
+		void stepBlueLights();
+
+		// Light sequences.
+		void runAnimation();
+		void applyKeyframe(const Keyframe& keyframe);
 
-		// Debug messages.
-		void debugPrint(const char message[], DEBUG::DEBUGLEVEL level);
-		void debugPrint(int message, DEBUG::DEBUGLEVEL level);
-		
-		void debugPrintLn(const char message[], DEBUG::DEBUGLEVEL level);
-		void debugPrintLn(int message, DEBUG::DEBUGLEVEL level);
+		// Audio.
+		void runAudioPulses();
+		void triggerAudio(uint8_t trigger);
+
+		// Overload.
+		unsigned int getOverloadDelay(uint8_t level);
+		void setOverloadPhase(OVERLOAD::PHASE previousPhase, OVERLOAD::PHASE phase);
+
+		// Sleep until the next interrupt.
+		void sleep();
+
+		// Commands received on the debug serial port.
+		//	t	Dump the trace.
+		//	l	Report the loop statistics (and the brightness engine's, when it is turned on).
+		//	c	Clear the loop statistics.
+		//	m	Report the memory use.
+		void runDebugCommands();
 	 		
 	private:
-		// Arduino pin and control settings.
-		Configuration*										_configuration;
-		
+		// The state sensors (in GENERATOR::STATE order), the buttons, and the ready indicator are accessed through the
+		// port registers when the board allows it.
+		typedef HAL::FastInputPins<Profile::stateInputPins[GENERATOR::OFF], Profile::stateInputPins[GENERATOR::PRIMED0],
+			Profile::stateInputPins[GENERATOR::PRIMED1], Profile::stateInputPins[GENERATOR::ON]>	StatePins;
+		typedef HAL::FastInputPins<Profile::modeButtonPin>													ModeButtonPin;
+		typedef HAL::FastInputPins<Profile::batteryMeterActivationPin>										BatteryMeterButtonPin;
+		typedef HAL::FastOutputPin<Profile::readyIndicatorPin>												ReadyIndicatorPin;
+
+		// Reads the sensors and buttons with the bits laid out as in INPUTBIT.  Called from the sample interrupt.
+		static uint8_t readInputs();
+
 		// Output.  Because of the number of outputs, a shift register is used.
-		ShiftRegister74HC595<nShiftRegisters>				_shiftRegister;
+		HAL::ShiftRegister<Profile::numberOfShiftRegisters>	_shiftRegister;
+
+		// All changes to the shift register outputs are staged here during a pass through update and sent to the
+		// shift register once at the end.
+		OutputFrame<Profile>								_outputFrame;
+
+		// The timers (SCHEDULER::TIMER) of everything that waits for a time.
+		Scheduler											_scheduler;
 
 		// Battery meter.
-		BatteryMeterShiftRegister<nShiftRegisters>			_batteryMeter;
-		AlwaysOnButton										_batteryMeterButton;
+		bool												_batteryMeterOn;
+
+		// Battery measurement and the low battery warning.
+		BatteryMonitor										_batteryMonitor;
+		bool												_batteryWarningOn;
+		bool												_batteryWarningLightOn;
 
-		// Virtual cycle button for special modes.
-		CycleButton											_modeButton;
+		// Virtual cycle button for special modes.  Each press advances the count by one, after the last special mode it
+		// wraps back around to zero.
+		uint8_t												_modeButtonCount;
 		GENERATOR::SPECIALMODE								_modeButtonValue;
 
+		// The hall effect sensors that detect the activation arm position and the buttons, debounced.  The last inputs
+		// read from it are kept to find what each edge changed.
+		InputCapture										_inputs;
+		uint8_t												_lastInputs;
+
 		// The current state of the generator.  This is the activation arm position.
 		GENERATOR::STATE									_generatorState;
 
@@ -136,11 +243,38 @@ class NaquadahGenerator
 		unsigned int                   						_lightDelay;
 
 		// Timer used to determine when to update blue lights and without blocking code execution with "delay."
-		SoftTimer											_lightTimer;
+		DeadlineTimer										_lightTimer;
+
+		// Eases the light delay to the overload level set with the mode button.
+		OverloadRamp										_overload;
+
+		// Light sequences (start up, special mode display, et cetera) that are played back without blocking.
+		Animation											_animation;
+
+		// Releases the audio trigger lines on the shift register after they have been held long enough.
+		PulseScheduler										_audioPulses;
 
 		// Audio serial communicator and chip interface class.
-		SoftwareSerial										_audioSerial;
+		HAL::AudioSerial									_audioSerial;
 		VS1000UART 											_vsUart;
+
+		#if useAudioSerial
+			// Plays the sounds over the audio serial port without waiting on the board.
+			AudioQueue										_audioQueue;
+		#endif
+
+		// Profiling hook for the state machines.
+		TransitionHook										_transitionHook;
+
+		#if useLoopStatistics
+			LoopStatistics									_loopStatistics;
+		#endif
+
+		#if useMemoryReport
+			// RAM and flash used by each part, reported from this table (stored in flash).
+			static const MemoryComponent					_memoryComponents[];
+			MemoryReport									_memoryReport;
+		#endif
 };
 
 #endif
\ No newline at end of file
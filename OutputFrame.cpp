@@ -0,0 +1,176 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "OutputFrame.h"
+
+template<typename Profile>
+OutputFrame<Profile>::OutputFrame(HAL::ShiftRegister<Profile::numberOfShiftRegisters>* shiftRegister) :
+	_shiftRegister(shiftRegister),
+	_dirty(true)
+	#if useBrightnessEngine
+		, _brightnessEngine(shiftRegister)
+	#endif
+{
+	for (int i = 0; i < Profile::numberOfShiftRegisters; i++)
+	{
+		_values[i] = 0;
+	}
+
+	#if useBrightnessEngine
+		for (int i = 0; i < Profile::numberOfOutputs; i++)
+		{
+			_brightness[i] = (1 << brightnessBits) - 1;
+		}
+	#endif
+}
+
+template<typename Profile>
+OutputFrame<Profile>::~OutputFrame()
+{
+}
+
+template<typename Profile>
+void OutputFrame<Profile>::begin()
+{
+	#if useBrightnessEngine
+		_brightnessEngine.begin();
+	#endif
+}
+
+template<typename Profile>
+void OutputFrame<Profile>::set(uint8_t output, uint8_t value)
+{
+	output			= Profile::outputs[output];
+	uint8_t mask	= 1 << (output % 8);
+	uint8_t old		= _values[output / 8];
+
+	if (value == LOW)
+	{
+		_values[output / 8] &= ~mask;
+	}
+	else
+	{
+		_values[output / 8] |= mask;
+	}
+
+	if (_values[output / 8] != old)
+	{
+		_dirty = true;
+	}
+}
+
+template<typename Profile>
+void OutputFrame<Profile>::setMasked(uint16_t mask, uint16_t values)
+{
+	// One pass for each of the (at most two) registers holding the first 16 outputs.
+	for (uint8_t i = 0; i < Profile::numberOfShiftRegisters && i < 2; i++)
+	{
+		uint8_t registerMask	= mask >> 8*i;
+		uint8_t old				= _values[i];
+
+		_values[i] = (old & ~registerMask) | ((values >> 8*i) & registerMask);
+
+		if (_values[i] != old)
+		{
+			_dirty = true;
+		}
+	}
+}
+
+template<typename Profile>
+uint8_t OutputFrame<Profile>::get(uint8_t output)
+{
+	output = Profile::outputs[output];
+	return (_values[output / 8] >> (output % 8)) & 1;
+}
+
+template<typename Profile>
+void OutputFrame<Profile>::setBrightness(uint8_t output, uint8_t brightness)
+{
+	#if useBrightnessEngine
+		output = Profile::outputs[output];
+		if (_brightness[output] != brightness)
+		{
+			_brightness[output] = brightness;
+			_dirty				= true;
+		}
+	#else
+		(void)output;
+		(void)brightness;
+	#endif
+}
+
+template<typename Profile>
+bool OutputFrame<Profile>::isDirty()
+{
+	return _dirty;
+}
+
+template<typename Profile>
+bool OutputFrame<Profile>::commit()
+{
+	if (!_dirty)
+	{
+		return false;
+	}
+
+	#if useBrightnessEngine
+		// Split the brightness of the outputs that are on into bit planes.
+		uint8_t planes[brightnessBits][Profile::numberOfShiftRegisters];
+
+		for (int plane = 0; plane < brightnessBits; plane++)
+		{
+			for (int i = 0; i < Profile::numberOfShiftRegisters; i++)
+			{
+				uint8_t bits = 0;
+				for (int bit = 0; bit < 8; bit++)
+				{
+					if (((_brightness[8*i + bit] >> plane) & 1) != 0)
+					{
+						bits |= 1 << bit;
+					}
+				}
+				planes[plane][i] = bits & _values[i];
+			}
+		}
+
+		_brightnessEngine.setPlanes(planes);
+	#else
+		_shiftRegister->setAll(_values);
+	#endif
+
+	_dirty = false;
+	return true;
+}
+
+#if useBrightnessEngine
+template<typename Profile>
+BrightnessEngine<Profile>* OutputFrame<Profile>::getBrightnessEngine()
+{
+	return &_brightnessEngine;
+}
+#endif
+
+// The profile that is built.  The simulator builds every profile, so a change that breaks one shows up whichever is
+// selected.  A new profile is added to its list.
+#if defined(ARDUINO)
+	template class OutputFrame<Configuration>;
+#else
+	template class OutputFrame<StandardProfile>;
+	template class OutputFrame<LowPowerProfile>;
+#endif
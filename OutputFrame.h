@@ -0,0 +1,87 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef OUTPUTFRAME_H
+#define OUTPUTFRAME_H
+
+#include "HardwareAbstraction.h"
+#include "Configuration.h"
+#include "BrightnessEngine.h"
+
+// Holds the state of every output on the shift registers.  Changes are only recorded (staged) when they are made and
+// are sent to the shift registers all at once when the frame is committed.  Committing does nothing if no output has
+// changed, so the registers are only shifted out and latched when needed and the lights never show the in between
+// states of a change.
+//
+// The lights and audio lines (LIGHT::SHIFTREGISTER and AUDIO::SHIFTREGISTER) are found on the outputs through the output
+// map of the profile.  Masks are of the outputs themselves.
+//
+// When the brightness engine is turned on, each output also has a brightness.  An output that is on is shown at its
+// brightness, and committing hands the outputs to the engine instead of the shift registers.
+template<typename Profile>
+class OutputFrame
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		OutputFrame(HAL::ShiftRegister<Profile::numberOfShiftRegisters>* shiftRegister);
+
+		// Default destructor.
+		~OutputFrame();
+
+	// Public interface.
+	public:
+		// Initialization.  Starts the brightness engine, if it is used.
+		void begin();
+
+		// Stage the value of a light or audio line.
+		void set(uint8_t output, uint8_t value);
+
+		// Stage the values of the first 16 outputs that have their bit set in "mask."  Bit n is output n.  Used to change a
+		// pattern of several lights at once.
+		void setMasked(uint16_t mask, uint16_t values);
+
+		// The staged value of a light or audio line.
+		uint8_t get(uint8_t output);
+
+		// Stage the brightness of a light (0 to 2^brightnessBits - 1).  Does nothing if the brightness engine is off.
+		void setBrightness(uint8_t output, uint8_t brightness);
+
+		// True if there are staged changes that have not been sent to the shift registers.
+		bool isDirty();
+
+		// Send the staged values to the shift registers if anything has changed.  Returns true if the registers were
+		// updated.
+		bool commit();
+
+		#if useBrightnessEngine
+			BrightnessEngine<Profile>* getBrightnessEngine();
+		#endif
+
+	private:
+		HAL::ShiftRegister<Profile::numberOfShiftRegisters>*	_shiftRegister;
+		uint8_t												_values[Profile::numberOfShiftRegisters];
+		bool												_dirty;
+
+		#if useBrightnessEngine
+			BrightnessEngine<Profile>						_brightnessEngine;
+			uint8_t											_brightness[Profile::numberOfOutputs];
+		#endif
+};
+
+#endif
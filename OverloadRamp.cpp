@@ -0,0 +1,144 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "OverloadRamp.h"
+
+OverloadRamp::OverloadRamp() :
+	_curve(OVERLOAD::LINEAR),
+	_criticalStepTime(0),
+	_stepTime(0),
+	_startStepTime(0),
+	_targetStepTime(0),
+	_carry(0),
+	_progress(0),
+	_progressPerFrame(1 << _fractionBits),
+	_phase(OVERLOAD::STEADY)
+{
+}
+
+OverloadRamp::~OverloadRamp()
+{
+}
+
+void OverloadRamp::begin(OVERLOAD::CURVE curve, uint8_t frames, unsigned int criticalStepTime)
+{
+	_curve				= curve;
+	_criticalStepTime	= (unsigned long)criticalStepTime << _fractionBits;
+
+	// Round up so the ramp never takes more frames than asked for.  The last frame lands exactly on the target.
+	frames				= frames == 0 ? 1 : frames;
+	_progressPerFrame	= ((1 << _fractionBits) + frames - 1) / frames;
+}
+
+void OverloadRamp::reset(unsigned int stepTime)
+{
+	_stepTime			= (unsigned long)stepTime << _fractionBits;
+	_startStepTime		= _stepTime;
+	_targetStepTime		= _stepTime;
+	_carry				= 0;
+	_progress			= 1 << _fractionBits;
+	_phase				= _stepTime <= _criticalStepTime ? OVERLOAD::CRITICAL : OVERLOAD::STEADY;
+}
+
+void OverloadRamp::setTarget(unsigned int stepTime)
+{
+	_startStepTime		= _stepTime;
+	_targetStepTime		= (unsigned long)stepTime << _fractionBits;
+	_progress			= 0;
+}
+
+unsigned int OverloadRamp::update()
+{
+	const uint16_t one = 1 << _fractionBits;
+
+	if (_progress < one)
+	{
+		_progress += _progressPerFrame;
+		if (_progress > one)
+		{
+			_progress = one;
+		}
+
+		// Shape the progress (0 to one) with the curve.
+		unsigned long t			= _progress;
+		unsigned long shaped	= t;
+		switch (_curve)
+		{
+			case OVERLOAD::EASEIN:
+			{
+				shaped = (t * t) >> _fractionBits;
+				break;
+			}
+
+			case OVERLOAD::EASEOUT:
+			{
+				unsigned long remaining = one - t;
+				shaped = one - ((remaining * remaining) >> _fractionBits);
+				break;
+			}
+
+			case OVERLOAD::SMOOTHSTEP:
+			{
+				// 3t^2 - 2t^3.
+				unsigned long squared = (t * t) >> _fractionBits;
+				shaped = (3 * squared) - ((2 * squared * t) >> _fractionBits);
+				break;
+			}
+
+			default:
+			{
+				break;
+			}
+		}
+
+		// Interpolate between the start and the target.  The ramp can go either way, so work with the distance.
+		if (_targetStepTime >= _startStepTime)
+		{
+			_stepTime = _startStepTime + (((_targetStepTime - _startStepTime) * shaped) >> _fractionBits);
+		}
+		else
+		{
+			_stepTime = _startStepTime - (((_startStepTime - _targetStepTime) * shaped) >> _fractionBits);
+		}
+	}
+
+	if (_progress < one)
+	{
+		_phase = OVERLOAD::RAMPING;
+	}
+	else
+	{
+		_phase = _stepTime <= _criticalStepTime ? OVERLOAD::CRITICAL : OVERLOAD::STEADY;
+	}
+
+	// Whole milliseconds for the timer.  The fraction left over is carried into the next frame.
+	unsigned int	wholeStepTime	= _stepTime >> _fractionBits;
+	uint16_t		carry			= _carry + (uint8_t)_stepTime;
+	if (carry >= one)
+	{
+		wholeStepTime++;
+	}
+	_carry = (uint8_t)carry;
+
+	return wholeStepTime;
+}
+
+OVERLOAD::PHASE OverloadRamp::getPhase()
+{
+	return _phase;
+}
@@ -0,0 +1,77 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef OVERLOADRAMP_H
+#define OVERLOADRAMP_H
+
+#include "HardwareAbstraction.h"
+#include "enums.h"
+
+// Eases the blue light step time (milliseconds) from where it is to a target over a fixed number of steps (frames).
+// The step time is kept in fixed point (8 fractional bits) and the leftover fractions are carried from one frame to
+// the next, so the average step time follows the curve exactly even though the timer works in whole milliseconds.
+//
+// Each frame costs the same: a few additions and at most three 32 bit multiplications, no division and no loops.  The
+// only division is made when a new target is set.
+class OverloadRamp
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		OverloadRamp();
+
+		// Default destructor.
+		~OverloadRamp();
+
+	// Public interface.
+	public:
+		// Set the curve, the number of frames a change takes, and the step time (milliseconds) at and below which the
+		// ramp is critical.
+		void begin(OVERLOAD::CURVE curve, uint8_t frames, unsigned int criticalStepTime);
+
+		// Jump to a step time (milliseconds) without ramping.
+		void reset(unsigned int stepTime);
+
+		// Start ramping from the current step time to a new one (milliseconds).
+		void setTarget(unsigned int stepTime);
+
+		// Advance one frame.  Returns the time (milliseconds) to the next step.
+		unsigned int update();
+
+		OVERLOAD::PHASE getPhase();
+
+	private:
+		// Fixed point format of the step times.
+		static const uint8_t								_fractionBits = 8;
+
+		OVERLOAD::CURVE										_curve;
+		unsigned long										_criticalStepTime;
+
+		unsigned long										_stepTime;
+		unsigned long										_startStepTime;
+		unsigned long										_targetStepTime;
+		uint8_t												_carry;
+
+		// Progress through the ramp, 0 to 256 (the end).
+		uint16_t											_progress;
+		uint16_t											_progressPerFrame;
+
+		OVERLOAD::PHASE										_phase;
+};
+
+#endif
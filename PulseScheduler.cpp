@@ -0,0 +1,120 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "PulseScheduler.h"
+
+PulseScheduler::PulseScheduler(Scheduler* scheduler, uint8_t timer) :
+	_scheduler(scheduler),
+	_timer(timer)
+{
+	clear();
+}
+
+PulseScheduler::~PulseScheduler()
+{
+}
+
+bool PulseScheduler::schedule(uint8_t output, uint8_t level, unsigned int delay)
+{
+	// A new change for an output replaces the old one.
+	cancel(output);
+
+	for (int i = 0; i < nPulseSchedulerSlots; i++)
+	{
+		if (!_slots[i].active)
+		{
+			_slots[i].active	= true;
+			_slots[i].output	= output;
+			_slots[i].level		= level;
+			_slots[i].startTime	= HAL::millis();
+			_slots[i].delay		= delay;
+			scheduleNextChange();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void PulseScheduler::cancel(uint8_t output)
+{
+	for (int i = 0; i < nPulseSchedulerSlots; i++)
+	{
+		if (_slots[i].active && _slots[i].output == output)
+		{
+			_slots[i].active = false;
+		}
+	}
+
+	scheduleNextChange();
+}
+
+void PulseScheduler::clear()
+{
+	for (int i = 0; i < nPulseSchedulerSlots; i++)
+	{
+		_slots[i].active = false;
+	}
+
+	_scheduler->cancel(_timer);
+}
+
+bool PulseScheduler::getNextChange(uint8_t& output, uint8_t& level)
+{
+	unsigned long now = HAL::millis();
+
+	for (int i = 0; i < nPulseSchedulerSlots; i++)
+	{
+		// Unsigned subtraction handles the roll over of millis.
+		if (_slots[i].active && now - _slots[i].startTime >= _slots[i].delay)
+		{
+			_slots[i].active	= false;
+			output				= _slots[i].output;
+			level				= _slots[i].level;
+			return true;
+		}
+	}
+
+	scheduleNextChange();
+	return false;
+}
+
+void PulseScheduler::scheduleNextChange()
+{
+	bool			pending		= false;
+	unsigned long	earliest	= 0;
+
+	for (int i = 0; i < nPulseSchedulerSlots; i++)
+	{
+		unsigned long time = _slots[i].startTime + _slots[i].delay;
+		if (_slots[i].active && (!pending || (long)(time - earliest) < 0))
+		{
+			pending		= true;
+			earliest	= time;
+		}
+	}
+
+	if (pending)
+	{
+		_scheduler->schedule(_timer, earliest);
+	}
+	else
+	{
+		_scheduler->cancel(_timer);
+	}
+}
@@ -0,0 +1,77 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef PULSESCHEDULER_H
+#define PULSESCHEDULER_H
+
+#include "HardwareAbstraction.h"
+#include "Scheduler.h"
+
+// Maximum number of outputs that can have a pending change at one time.
+#define nPulseSchedulerSlots 4
+
+// Schedules delayed level changes on outputs so that trigger lines can be pulsed without blocking.  The caller sets
+// the output to its active level, then schedules the release.  A timer of the scheduler is kept set to the earliest
+// pending change.  When it runs, call getNextChange to retrieve the changes that are due and apply them.  Each output can
+// have only one pending change, scheduling another replaces it.
+class PulseScheduler
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		// "Timer" is the timer of the scheduler that is set to the time of the earliest change.
+		PulseScheduler(Scheduler* scheduler, uint8_t timer);
+
+		// Default destructor.
+		~PulseScheduler();
+
+	// Public interface.
+	public:
+		// Set "output" to "level" after "delay" milliseconds.  Returns false if there are no free slots.
+		bool schedule(uint8_t output, uint8_t level, unsigned int delay);
+
+		// Remove any pending change for an output.
+		void cancel(uint8_t output);
+
+		// Remove all pending changes.
+		void clear();
+
+		// If a change is due, its output and level are returned and the change is removed.  Call repeatedly until it
+		// returns false to apply all the changes that are due.
+		bool getNextChange(uint8_t& output, uint8_t& level);
+
+	private:
+		// Set the timer to the earliest pending change, or stop it if there are none.
+		void scheduleNextChange();
+
+	private:
+		struct Slot
+		{
+			bool											active;
+			uint8_t											output;
+			uint8_t											level;
+			unsigned long									startTime;
+			unsigned int									delay;
+		};
+
+		Scheduler*											_scheduler;
+		uint8_t												_timer;
+		Slot												_slots[nPulseSchedulerSlots];
+};
+
+#endif
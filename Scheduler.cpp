@@ -0,0 +1,186 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "Scheduler.h"
+
+Scheduler::Scheduler() :
+	_numberOfRunning(0),
+	_maximumRunning(0)
+{
+	for (uint8_t i = 0; i < nSchedulerTimers; i++)
+	{
+		_positions[i] = notRunning;
+	}
+}
+
+Scheduler::~Scheduler()
+{
+}
+
+void Scheduler::schedule(uint8_t timer, unsigned long time)
+{
+	_deadlines[timer]	= time;
+	_periods[timer]		= 0;
+
+	if (_positions[timer] == notRunning)
+	{
+		// Add it to the back and let it move up to its place.
+		_heap[_numberOfRunning]	= timer;
+		_positions[timer]		= _numberOfRunning;
+		_numberOfRunning++;
+
+		if (_numberOfRunning > _maximumRunning)
+		{
+			_maximumRunning = _numberOfRunning;
+		}
+
+		moveUp(_positions[timer]);
+	}
+	else
+	{
+		// The deadline may have moved either way.
+		moveUp(_positions[timer]);
+		moveDown(_positions[timer]);
+	}
+}
+
+void Scheduler::start(uint8_t timer, unsigned int delay, unsigned int period)
+{
+	schedule(timer, HAL::millis() + delay);
+	_periods[timer] = period;
+}
+
+void Scheduler::cancel(uint8_t timer)
+{
+	if (_positions[timer] != notRunning)
+	{
+		remove(_positions[timer]);
+	}
+}
+
+bool Scheduler::isRunning(uint8_t timer)
+{
+	return _positions[timer] != notRunning;
+}
+
+bool Scheduler::getNextDue(uint8_t& timer)
+{
+	if (_numberOfRunning == 0)
+	{
+		return false;
+	}
+
+	unsigned long now = HAL::millis();
+	timer = _heap[0];
+
+	// The signed difference keeps working when millis rolls over.
+	if ((long)(now - _deadlines[timer]) < 0)
+	{
+		return false;
+	}
+
+	if (_periods[timer] == 0)
+	{
+		remove(0);
+		return true;
+	}
+
+	_deadlines[timer] += _periods[timer];
+	if ((long)(now - _deadlines[timer]) >= 0)
+	{
+		_deadlines[timer] = now + _periods[timer];
+	}
+	moveDown(0);
+	return true;
+}
+
+uint8_t Scheduler::getMaximumRunning()
+{
+	return _maximumRunning;
+}
+
+bool Scheduler::isBefore(uint8_t a, uint8_t b)
+{
+	long difference = (long)(_deadlines[_heap[a]] - _deadlines[_heap[b]]);
+	return difference < 0 || (difference == 0 && _heap[a] < _heap[b]);
+}
+
+void Scheduler::swap(uint8_t a, uint8_t b)
+{
+	uint8_t timer	= _heap[a];
+	_heap[a]		= _heap[b];
+	_heap[b]		= timer;
+
+	_positions[_heap[a]] = a;
+	_positions[_heap[b]] = b;
+}
+
+void Scheduler::moveUp(uint8_t position)
+{
+	while (position > 0)
+	{
+		uint8_t parent = (position - 1) / 2;
+		if (!isBefore(position, parent))
+		{
+			return;
+		}
+		swap(position, parent);
+		position = parent;
+	}
+}
+
+void Scheduler::moveDown(uint8_t position)
+{
+	while (true)
+	{
+		uint8_t child = 2*position + 1;
+		if (child >= _numberOfRunning)
+		{
+			return;
+		}
+
+		// Take the earlier of the two children.
+		if (child + 1 < _numberOfRunning && isBefore(child + 1, child))
+		{
+			child++;
+		}
+
+		if (!isBefore(child, position))
+		{
+			return;
+		}
+		swap(position, child);
+		position = child;
+	}
+}
+
+void Scheduler::remove(uint8_t position)
+{
+	uint8_t timer = _heap[position];
+	_positions[timer] = notRunning;
+	_numberOfRunning--;
+
+	// Fill the hole with the last timer and put it in its place.
+	if (position < _numberOfRunning)
+	{
+		_heap[position]					= _heap[_numberOfRunning];
+		_positions[_heap[position]]		= position;
+		moveUp(position);
+		moveDown(position);
+	}
+}
@@ -0,0 +1,97 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "HardwareAbstraction.h"
+
+// Number of timers the scheduler can hold.  Timers are numbered from 0 to nSchedulerTimers - 1.  No more than 255.
+#define nSchedulerTimers 8
+
+// Keeps the deadlines of the generator's timers so the loop only has to look at the earliest one.  The parts of the
+// generator that wait for a time (light sequences, audio pulses, the blue light steps, the battery) set a timer and are
+// only run when it comes due, instead of each checking its own clock on every pass through the loop.
+//
+// The running timers are kept in a binary min-heap of deadlines (milliseconds, same clock as millis) in a fixed pool, so
+// nothing is allocated.  Checking for a due timer is a single comparison with the front of the heap.  Starting, moving,
+// and removing a timer take at most log2(nSchedulerTimers) swaps.  Deadlines are compared as signed differences, which
+// handles the roll over of millis as long as no deadline is more than 24 days away from the others.
+//
+// Each timer can only be waiting for one deadline.  Setting a timer that is already running moves it.  Timers due at
+// the same time are returned in timer number order.
+class Scheduler
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		Scheduler();
+
+		// Default destructor.
+		~Scheduler();
+
+	// Public interface.
+	public:
+		// Run "timer" at "time" (milliseconds, same clock as millis).  A time that has already passed is due right away.
+		void schedule(uint8_t timer, unsigned long time);
+
+		// Run "timer" "delay" milliseconds from now and then every "period" milliseconds (0 to run it once).  Periodic
+		// timers keep absolute deadlines.  If one is handled more than a period late, it starts over from then.
+		void start(uint8_t timer, unsigned int delay, unsigned int period = 0);
+
+		// Stop a timer.  Does nothing if it isn't running.
+		void cancel(uint8_t timer);
+
+		// True if the timer is waiting for its deadline.
+		bool isRunning(uint8_t timer);
+
+		// If a timer is due, it is returned and removed (or moved to its next deadline if it is periodic).  Call
+		// repeatedly until it returns false to run all the timers that are due.
+		bool getNextDue(uint8_t& timer);
+
+		// Most timers that were running at the same time.
+		uint8_t getMaximumRunning();
+
+	private:
+		// True if the timer at heap position "a" should run before the one at "b".
+		bool isBefore(uint8_t a, uint8_t b);
+
+		void swap(uint8_t a, uint8_t b);
+
+		// Move the timer at heap position "position" towards the front or the back until the heap is in order again.
+		void moveUp(uint8_t position);
+		void moveDown(uint8_t position);
+
+		void remove(uint8_t position);
+
+	private:
+		// Marks a timer that is not in the heap.
+		static const uint8_t								notRunning = 0xFF;
+
+		unsigned long										_deadlines[nSchedulerTimers];
+		unsigned int										_periods[nSchedulerTimers];
+
+		// The heap holds timer numbers, earliest deadline first.  The position of each timer in it is kept so it can be
+		// moved or removed without a search.
+		uint8_t												_heap[nSchedulerTimers];
+		uint8_t												_positions[nSchedulerTimers];
+		uint8_t												_numberOfRunning;
+		uint8_t												_maximumRunning;
+};
+
+#endif
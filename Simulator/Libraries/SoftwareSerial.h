@@ -0,0 +1,140 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#ifndef SOFTWARESERIAL_H
+#define SOFTWARESERIAL_H
+
+#include "SimulatedHardware.h"
+
+// Size of the receive buffer in the real library.
+#define nSoftwareSerialBuffer			64
+
+// Simulator replacement for the Arduino SoftwareSerial library.  Writes block for the time it takes to send a byte at the
+// baud rate, the same as the real library.  The other end of the port is the simulated audio board, which gets the bytes
+// written and supplies the bytes received with receive.
+class SoftwareSerial
+{
+	// Constructors.
+	public:
+		SoftwareSerial(uint8_t receivePin, uint8_t transmitPin) :
+			_receivePin(receivePin),
+			_transmitPin(transmitPin),
+			_baud(0),
+			_head(0),
+			_tail(0),
+			_bytesWritten(0)
+		{
+		}
+
+	// Public interface.
+	public:
+		void begin(long baud)
+		{
+			_baud = baud;
+			SimulatedHardware::instance().getAudioBoard().connect(this, baud);
+		}
+
+		bool listen()
+		{
+			return true;
+		}
+
+		size_t write(uint8_t value)
+		{
+			if (_baud == 0)
+			{
+				return 0;
+			}
+
+			// The real library sends with interrupts off, so the whole byte blocks.
+			SimulatedHardware::instance().advance(10000000UL / _baud);
+			SimulatedHardware::instance().getAudioBoard().receive(value);
+			_bytesWritten++;
+			return 1;
+		}
+
+		size_t print(const char message[])
+		{
+			size_t count = 0;
+			while (message[count] != '\0')
+			{
+				write(message[count]);
+				count++;
+			}
+			return count;
+		}
+
+		int available()
+		{
+			SimulatedHardware::instance().getAudioBoard().deliver();
+			return (_tail + nSoftwareSerialBuffer - _head) % nSoftwareSerialBuffer;
+		}
+
+		int read()
+		{
+			SimulatedHardware::instance().getAudioBoard().deliver();
+			if (_head == _tail)
+			{
+				return -1;
+			}
+
+			uint8_t value	= _buffer[_head];
+			_head			= (_head + 1) % nSoftwareSerialBuffer;
+			return value;
+		}
+
+		int peek()
+		{
+			SimulatedHardware::instance().getAudioBoard().deliver();
+			return _head == _tail ? -1 : _buffer[_head];
+		}
+
+		void flush()
+		{
+		}
+
+	// Simulation interface.
+	public:
+		// Bytes sent by the other device.  Dropped if the buffer is full, like the real library.
+		void receive(uint8_t value)
+		{
+			uint8_t next = (_tail + 1) % nSoftwareSerialBuffer;
+			if (next != _head)
+			{
+				_buffer[_tail]	= value;
+				_tail			= next;
+			}
+		}
+
+		unsigned long getBytesWritten()
+		{
+			return _bytesWritten;
+		}
+
+	private:
+		uint8_t											_receivePin;
+		uint8_t											_transmitPin;
+		long											_baud;
+
+		uint8_t											_buffer[nSoftwareSerialBuffer];
+		uint8_t											_head;
+		uint8_t											_tail;
+
+		unsigned long									_bytesWritten;
+};
+
+#endif
@@ -0,0 +1,81 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#ifndef VS1000UART_H
+#define VS1000UART_H
+
+#include "HardwareAbstraction.h"
+
+// Simulator replacement for the VS1000UART library.  Only the parts used by the generator are provided.
+class VS1000UART
+{
+	public:
+		enum VOLUMELEVEL
+		{
+			VOLUME0,
+			VOLUME1,
+			VOLUME2,
+			VOLUME3,
+			VOLUME4,
+			VOLUME5
+		};
+
+	// Constructors.
+	public:
+		VS1000UART(SoftwareSerial* serial, int resetPin) :
+			_serial(serial),
+			_resetPin(resetPin)
+		{
+		}
+
+	// Public interface.
+	public:
+		void useLowerLevelOne(bool useLowerLevelOne)
+		{
+			(void)useLowerLevelOne;
+		}
+
+		void setMaximumLevel(VOLUMELEVEL level)
+		{
+			(void)level;
+		}
+
+		void setMinimumVolume(uint8_t volume)
+		{
+			(void)volume;
+		}
+
+		void setMaximumVolume(uint8_t volume)
+		{
+			(void)volume;
+		}
+
+		// Pulses the reset line of the audio board.
+		void begin()
+		{
+			HAL::pinMode(_resetPin, OUTPUT);
+			HAL::digitalWrite(_resetPin, LOW);
+			HAL::delay(10);
+			HAL::digitalWrite(_resetPin, HIGH);
+		}
+
+	private:
+		SoftwareSerial*									_serial;
+		int												_resetPin;
+};
+
+#endif
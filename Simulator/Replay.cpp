@@ -0,0 +1,344 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+/*
+	Replays a timeline of arm, button and battery events against the generator on the virtual clock and reports how the
+	generator reacted to each one.  Runs are deterministic, so the numbers can be compared between builds to catch
+	regressions.
+
+	For every event the report gives:
+		Latency		For arm events, the time until the generator fired the state change audio trigger (or, with
+					useAudioSerial, until the audio board received the command to play the state change sound).  For
+					button events, the time until the shift register outputs changed.  Only events the generator answers by
+					changing its outputs are measured: pressing the mode button in the off position (the special mode is
+					blinked on the blue lights) and pressing or letting go of the battery button in the battery meter mode.
+					Other events, and events that got no reaction, show "-" so an unrelated latch, such as the next step
+					of a light sequence, isn't taken for their reaction.
+		Loops		Number of passes through the loop it took to react.
+		Latches		Shift register latches from the event until the next event.
+
+	Usage:
+		NaquadahReplay timeline [--step microseconds] [--settle milliseconds] [--max-latency milliseconds] [--serial]
+			[--trace file]
+
+		--step			Virtual time each pass through the loop takes (default 100 microseconds).
+		--settle		Time to keep running after the last event (default 2000 milliseconds).
+		--max-latency	Exit with an error if any reaction takes longer than this.
+		--serial		Echo the generator's debug serial output to the console.
+		--trace			At the end, ask the generator for its trace and save the serial output to a file.  Decode it
+						with NaquadahTrace.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "Timeline.h"
+
+// Sends the trace dump command and runs the loop until the dump has been sent out, capturing the serial port to a file.
+static bool dumpTrace(NaquadahGenerator<Configuration>& generator, unsigned long step, const char fileName[])
+{
+	#if useTrace
+		FILE* file = fopen(fileName, "w");
+		if (file == nullptr)
+		{
+			fprintf(stderr, "Unable to create \"%s\".\n", fileName);
+			return false;
+		}
+
+		SimulatedHardware&	hardware	= SimulatedHardware::instance();
+		SimulatedSerial&	serial		= hardware.getSerial();
+
+		serial.setCapture(file);
+		serial.receive("t");
+
+		do
+		{
+			generator.update();
+			hardware.advance(step);
+		}
+		while (Trace::isDumping() || Log::getFree() < nLogBufferBytes - 1);
+
+		serial.setCapture(nullptr);
+		fclose(file);
+		return true;
+	#else
+		(void)generator;
+		(void)step;
+		(void)fileName;
+		fprintf(stderr, "The trace is turned off (useTrace in Configuration.h).\n");
+		return false;
+	#endif
+}
+
+// Where the generator is, kept up to date by its transition hook.
+static GENERATOR::STATE			generatorState	= GENERATOR::OFF;
+static GENERATOR::SPECIALMODE	specialMode		= GENERATOR::SPECIALMODEOFF;
+
+static void recordTransition(STATEMACHINE::MACHINE machine, uint8_t, uint8_t to, unsigned long)
+{
+	if (machine == STATEMACHINE::GENERATORSTATE)
+	{
+		generatorState = (GENERATOR::STATE)to;
+	}
+	else
+	{
+		specialMode = (GENERATOR::SPECIALMODE)to;
+	}
+}
+
+// Whether the generator is expected to change its outputs in response to an event.  In the on position, the mode button
+// only sets the target of the overload ramp, and letting go of it, moving the arm and changing the battery reading don't
+// change anything straight away.
+static bool expectsReaction(const TimelineEvent& event)
+{
+	switch (event.action)
+	{
+		case TIMELINE::ARM:
+		{
+			return true;
+		}
+
+		case TIMELINE::PRESS:
+		case TIMELINE::RELEASE:
+		{
+			if (generatorState != GENERATOR::OFF)
+			{
+				return false;
+			}
+			if (event.value == TIMELINE::BATTERYBUTTON)
+			{
+				return specialMode == GENERATOR::SPECIALMODE01;
+			}
+			return event.action == TIMELINE::PRESS;
+		}
+
+		default:
+		{
+			return false;
+		}
+	}
+}
+
+struct Reaction
+{
+	bool												measured;
+	uint64_t											eventTime;
+	bool												reacted;
+	uint64_t											latency;
+	unsigned long										loops;
+	unsigned long										latches;
+};
+
+int main(int argc, char* argv[])
+{
+	const char*		fileName	= nullptr;
+	unsigned long	step		= 100;
+	unsigned long	settle		= 2000;
+	double			maxLatency	= -1;
+	bool			echoSerial	= false;
+	const char*		traceName	= nullptr;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--step") == 0 && i+1 < argc)
+		{
+			step = strtoul(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--settle") == 0 && i+1 < argc)
+		{
+			settle = strtoul(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--max-latency") == 0 && i+1 < argc)
+		{
+			maxLatency = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--serial") == 0)
+		{
+			echoSerial = true;
+		}
+		else if (strcmp(argv[i], "--trace") == 0 && i+1 < argc)
+		{
+			traceName = argv[++i];
+		}
+		else if (argv[i][0] != '-' && fileName == nullptr)
+		{
+			fileName = argv[i];
+		}
+		else
+		{
+			fileName = nullptr;
+			break;
+		}
+	}
+
+	if (fileName == nullptr)
+	{
+		fprintf(stderr, "Usage: %s timeline [--step microseconds] [--settle milliseconds] [--max-latency milliseconds] [--serial] [--trace file]\n", argv[0]);
+		return 1;
+	}
+
+	Timeline timeline;
+	if (!timeline.load(fileName))
+	{
+		return 1;
+	}
+
+	SimulatedHardware& hardware = SimulatedHardware::instance();
+	hardware.getSerial().setEcho(echoSerial);
+
+	// Events at time zero describe how things are when the power is turned on, so apply them before starting.
+	Configuration configuration;
+	hardware.driveInput(configuration.stateInputPins[GENERATOR::OFF], LOW);
+	hardware.setAnalogInput(configuration.batteryMeterSensePin, configuration.batteryMaxReading);
+
+	size_t nextEvent = 0;
+	while (nextEvent < timeline.size() && timeline[nextEvent].time == 0)
+	{
+		Timeline::apply(timeline[nextEvent++], configuration);
+	}
+
+	if (debugLevel > DEBUG::OFF)
+	{
+		Log::begin(9600);
+	}
+
+	NaquadahGenerator<Configuration> generator;
+	generator.setTransitionHook(recordTransition);
+	generator.begin();
+
+	std::vector<Reaction>	reactions(timeline.size());
+	uint64_t				endTime		= (timeline.size() ? timeline[timeline.size()-1].time : 0) + 1000*settle;
+	size_t					firstEvent	= nextEvent;
+	unsigned long			loops		= 0;
+
+	hardware.resetCounters();
+	Log::resetStatistics();
+
+	while (hardware.getTime() < endTime)
+	{
+		while (nextEvent < timeline.size() && timeline[nextEvent].time <= hardware.getTime())
+		{
+			Timeline::apply(timeline[nextEvent], configuration);
+			reactions[nextEvent].measured	= expectsReaction(timeline[nextEvent]);
+			reactions[nextEvent].eventTime	= timeline[nextEvent].time;
+			reactions[nextEvent].reacted	= false;
+			reactions[nextEvent].loops		= 0;
+			reactions[nextEvent].latches	= hardware.getCounters().shiftRegisterLatches;
+			nextEvent++;
+		}
+
+		generator.update();
+		loops++;
+
+		// The reaction to the most recent event.
+		if (nextEvent > firstEvent)
+		{
+			Reaction& reaction = reactions[nextEvent-1];
+			if (reaction.measured && !reaction.reacted)
+			{
+				uint64_t	changeTime	= hardware.getShiftRegisterChangeTime();
+				bool		changed		= hardware.getCounters().shiftRegisterChanges > 0;
+
+				if (timeline[nextEvent-1].action == TIMELINE::ARM)
+				{
+					#if useAudioSerial
+						changeTime	= hardware.getAudioBoard().getLastPlayTime();
+						changed		= hardware.getAudioBoard().getLastFile() == "STATECHGOGG";
+					#else
+						changeTime	= hardware.getShiftRegisterChangeTime(Configuration::outputs[AUDIO::STATECHANGE]);
+					#endif
+				}
+
+				reaction.loops++;
+				if (changed && changeTime >= reaction.eventTime)
+				{
+					reaction.reacted = true;
+					reaction.latency = changeTime - reaction.eventTime;
+				}
+			}
+		}
+
+		hardware.advance(step);
+	}
+
+	// Count the latches from each event to the next.
+	for (size_t i = firstEvent; i < nextEvent; i++)
+	{
+		unsigned long next		= i+1 < nextEvent ? reactions[i+1].latches : hardware.getCounters().shiftRegisterLatches;
+		reactions[i].latches	= next - reactions[i].latches;
+	}
+
+	printf("%12s  %-20s %12s %8s %8s\n", "Time (ms)", "Event", "Latency (ms)", "Loops", "Latches");
+
+	uint64_t		maximum			= 0;
+	uint64_t		total			= 0;
+	unsigned long	reacted			= 0;
+	size_t			slowest			= firstEvent;
+
+	for (size_t i = firstEvent; i < nextEvent; i++)
+	{
+		char		description[64];
+		Reaction&	reaction = reactions[i];
+
+		Timeline::describe(timeline[i], description, sizeof(description));
+
+		if (reaction.reacted)
+		{
+			printf("%12.3f  %-20s %12.3f %8lu %8lu\n", reaction.eventTime/1000.0, description, reaction.latency/1000.0, reaction.loops, reaction.latches);
+
+			reacted++;
+			total += reaction.latency;
+			if (reaction.latency > maximum)
+			{
+				maximum = reaction.latency;
+				slowest = i;
+			}
+		}
+		else
+		{
+			printf("%12.3f  %-20s %12s %8s %8lu\n", reaction.eventTime/1000.0, description, "-", "-", reaction.latches);
+		}
+	}
+
+	const SimulatedHardware::Counters& counters = hardware.getCounters();
+	char description[64];
+
+	printf("\n");
+	printf("Events:                  %lu (%lu got a reaction)\n", (unsigned long)(nextEvent - firstEvent), reacted);
+	printf("Mean latency:            %.3f ms\n", reacted ? total/1000.0/reacted : 0.0);
+	printf("Maximum latency:         %.3f ms (%s)\n", maximum/1000.0, reacted ? Timeline::describe(timeline[slowest], description, sizeof(description)) : "-");
+	printf("Loops:                   %lu\n", loops);
+	printf("Shift register latches:  %lu (%lu changed the outputs, %.3f ms shifting)\n", counters.shiftRegisterLatches, counters.shiftRegisterChanges, counters.shiftRegisterMicroseconds/1000.0);
+	printf("Timer interrupts:        %lu (%.3f ms, %.1f%% of the processor)\n", counters.interrupts, counters.interruptMicroseconds/1000.0, loops ? 100.0*counters.interruptMicroseconds/(double)hardware.getTime() : 0.0);
+	printf("Debug serial bytes:      %lu (%.1f ms blocked)\n", hardware.getSerial().getBytesWritten(), hardware.getSerial().getBlockedMicroseconds()/1000.0);
+	printf("Debug log bytes:         %lu queued, %lu dropped (%u of %u buffer bytes used at most)\n", Log::getBytesQueued(), Log::getBytesDropped(), (unsigned int)Log::getMaximumUsed(), (unsigned int)nLogBufferBytes);
+
+	if (traceName != nullptr && !dumpTrace(generator, step, traceName))
+	{
+		return 1;
+	}
+
+	if (maxLatency >= 0 && maximum/1000.0 > maxLatency)
+	{
+		printf("\nMaximum latency exceeds the %.3f ms limit.\n", maxLatency);
+		return 2;
+	}
+
+	return 0;
+}
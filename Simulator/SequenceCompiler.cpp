@@ -0,0 +1,503 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+/*
+	Compiles the text description of the light sequences (see LightSequences.txt for the format) into the packed tables
+	the generator plays from flash (see Animation.h).  The includes are expanded and everything is checked, so a
+	mistake is reported here and not found by watching the lights.
+
+	Usage:
+		NaquadahSequenceCompiler input output
+
+		Reads the text from "input" and writes the C++ header to "output."  Nothing is written if there is a mistake.
+*/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "Animation.h"
+
+namespace
+{
+	struct Name
+	{
+		const char*									text;
+		const char*									symbol;
+		int											value;
+	};
+
+	// What an action takes as its value.
+	enum OPERAND
+	{
+		NONE,
+		LIGHTNAME,
+		AUDIONAME,
+		NUMBER
+	};
+
+	struct ActionName
+	{
+		const char*									text;
+		const char*									symbol;
+		ANIMATION::ACTION							action;
+		OPERAND										operand;
+	};
+
+	const ActionName actionNames[] =
+	{
+		{"wait",			"ANIMATION::WAIT",				ANIMATION::WAIT,			NONE		},
+		{"lighton",			"ANIMATION::LIGHTON",			ANIMATION::LIGHTON,			LIGHTNAME	},
+		{"lightoff",		"ANIMATION::LIGHTOFF",			ANIMATION::LIGHTOFF,		LIGHTNAME	},
+		{"bluelightson",	"ANIMATION::BLUELIGHTSON",		ANIMATION::BLUELIGHTSON,	NUMBER		},
+		{"bluelightsoff",	"ANIMATION::BLUELIGHTSOFF",		ANIMATION::BLUELIGHTSOFF,	NONE		},
+		{"readyon",			"ANIMATION::READYON",			ANIMATION::READYON,			NONE		},
+		{"readyoff",		"ANIMATION::READYOFF",			ANIMATION::READYOFF,		NONE		},
+		{"batterymeter",	"ANIMATION::BATTERYMETER",		ANIMATION::BATTERYMETER,	NONE		},
+		{"brightness",		"ANIMATION::BRIGHTNESS",		ANIMATION::BRIGHTNESS,		NUMBER		},
+		{"audio",			"ANIMATION::AUDIOTRIGGER",		ANIMATION::AUDIOTRIGGER,	AUDIONAME	}
+	};
+
+	const Name lightNames[] =
+	{
+		{"RED",			"LIGHT::RED",			LIGHT::RED			},
+		{"BLUE1",		"LIGHT::BLUE1",			LIGHT::BLUE1		},
+		{"BLUE2",		"LIGHT::BLUE2",			LIGHT::BLUE2		},
+		{"BLUE3",		"LIGHT::BLUE3",			LIGHT::BLUE3		},
+		{"BLUE4",		"LIGHT::BLUE4",			LIGHT::BLUE4		},
+		{"BLUE5",		"LIGHT::BLUE5",			LIGHT::BLUE5		},
+		{"WHITE",		"LIGHT::WHITE",			LIGHT::WHITE		},
+		{"GREEN",		"LIGHT::GREEN",			LIGHT::GREEN		},
+		{"READY",		"LIGHT::READY",			LIGHT::READY		}
+	};
+
+	const Name audioNames[] =
+	{
+		{"RESET",		"AUDIO::RESET",			AUDIO::RESET		},
+		{"LATCH",		"AUDIO::LATCH",			AUDIO::LATCH		},
+		{"ON",			"AUDIO::ON",			AUDIO::ON			},
+		{"RANDOM",		"AUDIO::RANDOM",		AUDIO::RANDOM		},
+		{"UG",			"AUDIO::UG",			AUDIO::UG			},
+		{"STATECHANGE",	"AUDIO::STATECHANGE",	AUDIO::STATECHANGE	},
+		{"OVERLOAD",	"AUDIO::OVERLOAD",		AUDIO::OVERLOAD		}
+	};
+
+	template <size_t count>
+	const Name* findName(const Name (&names)[count], const char text[])
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (strcmp(names[i].text, text) == 0)
+			{
+				return &names[i];
+			}
+		}
+		return nullptr;
+	}
+
+	// A step as it is written to the header.
+	struct Step
+	{
+		int											delay;
+		std::string									action;
+		std::string									value;
+	};
+
+	struct Sequence
+	{
+		std::string									name;
+		std::vector<Step>							steps;
+	};
+
+	class Compiler
+	{
+		public:
+			Compiler(const char fileName[]) :
+				_fileName(fileName),
+				_lineNumber(0),
+				_errors(0),
+				_current(nullptr),
+				_inRepeat(false)
+			{
+			}
+
+			bool compile(FILE* file)
+			{
+				char line[256];
+
+				while (fgets(line, sizeof(line), file) != nullptr)
+				{
+					_lineNumber++;
+
+					char* comment = strchr(line, '#');
+					if (comment != nullptr)
+					{
+						*comment = '\0';
+					}
+
+					char	first[32]	= "";
+					char	second[32]	= "";
+					char	third[32]	= "";
+					char	extra[32]	= "";
+					int		fields		= sscanf(line, "%31s %31s %31s %31s", first, second, third, extra);
+
+					if (fields <= 0)
+					{
+						// Blank line.
+						continue;
+					}
+
+					if (fields == 4)
+					{
+						error("too much on the line");
+					}
+					else if (strcmp(first, "sequence") == 0)
+					{
+						startSequence(fields == 2 ? second : nullptr);
+					}
+					else if (_current == nullptr)
+					{
+						error("\"%s\" is outside of a sequence", first);
+					}
+					else if (strcmp(first, "end") == 0)
+					{
+						endSequence();
+					}
+					else if (strcmp(first, "repeat") == 0)
+					{
+						repeat(fields == 2 ? second : nullptr);
+					}
+					else if (strcmp(first, "loop") == 0)
+					{
+						loop();
+					}
+					else if (strcmp(first, "sync") == 0)
+					{
+						sync(fields == 1);
+					}
+					else if (strcmp(first, "include") == 0)
+					{
+						include(fields == 2 ? second : nullptr);
+					}
+					else
+					{
+						step(first, fields >= 2 ? second : nullptr, fields >= 3 ? third : nullptr);
+					}
+				}
+
+				if (_current != nullptr)
+				{
+					error("sequence \"%s\" has no end", _current->name.c_str());
+				}
+
+				return _errors == 0;
+			}
+
+			void write(FILE* file)
+			{
+				fprintf(file, "%s", license);
+				fprintf(file, "\n// Generated from %s by NaquadahSequenceCompiler.  Edit the text and compile it again, do not edit this file.\n", baseName(_fileName));
+				fprintf(file, "\n#ifndef LIGHTSEQUENCES_H\n#define LIGHTSEQUENCES_H\n\n#include \"Animation.h\"\n");
+
+				size_t total = 0;
+				for (size_t i = 0; i < _sequences.size(); i++)
+				{
+					const Sequence& sequence = _sequences[i];
+					size_t bytes = 2*(sequence.steps.size() + 1);
+					total += bytes;
+
+					fprintf(file, "\n// %s, %u bytes.\n", sequence.name.c_str(), (unsigned int)bytes);
+					fprintf(file, "const uint8_t sequence%s[] PROGMEM =\n{\n", sequence.name.c_str());
+					for (size_t j = 0; j < sequence.steps.size(); j++)
+					{
+						const Step& step = sequence.steps[j];
+						fprintf(file, "\tanimationStep(%d, %s, %s),\n", step.delay, step.action.c_str(), step.value.c_str());
+					}
+					fprintf(file, "\tanimationStep(0, ANIMATION::END, 0)\n};\n");
+				}
+
+				fprintf(file, "\n// %u sequences, %u bytes of flash.\n#define lightSequenceBytes %u\n\n#endif\n", (unsigned int)_sequences.size(), (unsigned int)total, (unsigned int)total);
+			}
+
+		private:
+			void startSequence(const char name[])
+			{
+				if (_current != nullptr)
+				{
+					error("sequence \"%s\" has no end", _current->name.c_str());
+				}
+
+				if (name == nullptr)
+				{
+					error("a sequence needs a name");
+					name = "";
+				}
+				else if (findSequence(name) != nullptr)
+				{
+					error("there is already a sequence named \"%s\"", name);
+				}
+
+				Sequence sequence;
+				sequence.name = name;
+				_sequences.push_back(sequence);
+				_current	= &_sequences.back();
+				_inRepeat	= false;
+			}
+
+			void endSequence()
+			{
+				if (_inRepeat)
+				{
+					error("repeat without a loop");
+				}
+				_current = nullptr;
+			}
+
+			void repeat(const char count[])
+			{
+				int value = count == nullptr ? -1 : number(count);
+				if (value < 1)
+				{
+					error("repeat needs a count of 1 to 254");
+				}
+
+				if (_inRepeat)
+				{
+					error("repeats can't be nested");
+				}
+				_inRepeat = true;
+
+				addStep(0, "ANIMATION::REPEAT", count == nullptr ? "0" : count);
+			}
+
+			void loop()
+			{
+				if (!_inRepeat)
+				{
+					error("loop without a repeat");
+				}
+				_inRepeat = false;
+
+				addStep(0, "ANIMATION::LOOP", "0");
+			}
+
+			void sync(bool alone)
+			{
+				if (!alone)
+				{
+					error("sync doesn't take a value");
+				}
+
+				addStep(0, "ANIMATION::SYNC", "0");
+			}
+
+			void include(const char name[])
+			{
+				const Sequence* sequence = name == nullptr ? nullptr : findSequence(name);
+				if (sequence == nullptr || sequence == _current)
+				{
+					error("include needs the name of a sequence defined above");
+					return;
+				}
+
+				for (size_t i = 0; i < sequence->steps.size(); i++)
+				{
+					const Step& step = sequence->steps[i];
+					if (_inRepeat && step.action == "ANIMATION::REPEAT")
+					{
+						error("\"%s\" has a repeat, which can't be included in a repeat", name);
+					}
+					_current->steps.push_back(step);
+				}
+			}
+
+			void step(const char delayText[], const char actionText[], const char valueText[])
+			{
+				int delay = number(delayText);
+				if (delay < 0 || delay > 15)
+				{
+					error("the delay must be 0 to 15 beats, not \"%s\"", delayText);
+					return;
+				}
+
+				const ActionName* action = nullptr;
+				for (size_t i = 0; actionText != nullptr && i < sizeof(actionNames)/sizeof(actionNames[0]); i++)
+				{
+					if (strcmp(actionNames[i].text, actionText) == 0)
+					{
+						action = &actionNames[i];
+					}
+				}
+
+				if (action == nullptr)
+				{
+					error("unknown action \"%s\"", actionText == nullptr ? "" : actionText);
+					return;
+				}
+
+				if ((action->operand == NONE) != (valueText == nullptr))
+				{
+					error(action->operand == NONE ? "\"%s\" doesn't take a value" : "\"%s\" needs a value", action->text);
+					return;
+				}
+
+				std::string value = "0";
+				if (valueText != nullptr && strcmp(valueText, "argument") == 0)
+				{
+					value = "ANIMATION::ARGUMENT";
+				}
+				else if (action->operand == LIGHTNAME || action->operand == AUDIONAME)
+				{
+					const Name* name = action->operand == LIGHTNAME ? findName(lightNames, valueText) : findName(audioNames, valueText);
+					if (name == nullptr)
+					{
+						error("unknown %s \"%s\"", action->operand == LIGHTNAME ? "light" : "audio trigger", valueText);
+						return;
+					}
+					value = name->symbol;
+				}
+				else if (action->operand == NUMBER)
+				{
+					if (number(valueText) < 0)
+					{
+						error("the value must be 0 to 254 or \"argument\", not \"%s\"", valueText);
+						return;
+					}
+					value = valueText;
+				}
+
+				addStep(delay, action->symbol, value);
+			}
+
+			void addStep(int delay, const char action[], const std::string& value)
+			{
+				Step step = {delay, action, value};
+				_current->steps.push_back(step);
+			}
+
+			const Sequence* findSequence(const char name[])
+			{
+				for (size_t i = 0; i < _sequences.size(); i++)
+				{
+					if (_sequences[i].name == name)
+					{
+						return &_sequences[i];
+					}
+				}
+				return nullptr;
+			}
+
+			// A number from 0 to 254 (255 is ANIMATION::ARGUMENT), or -1 if it isn't one.
+			static int number(const char text[])
+			{
+				char* end;
+				long value = strtol(text, &end, 10);
+				if (*text == '\0' || *end != '\0' || value < 0 || value >= ANIMATION::ARGUMENT)
+				{
+					return -1;
+				}
+				return (int)value;
+			}
+
+			static const char* baseName(const char fileName[])
+			{
+				const char* slash = strrchr(fileName, '/');
+				return slash == nullptr ? fileName : slash + 1;
+			}
+
+			void error(const char format[], ...) __attribute__((format(printf, 2, 3)))
+			{
+				va_list arguments;
+				va_start(arguments, format);
+				fprintf(stderr, "%s:%d: ", _fileName, _lineNumber);
+				vfprintf(stderr, format, arguments);
+				fprintf(stderr, ".\n");
+				va_end(arguments);
+				_errors++;
+			}
+
+		private:
+			static const char*							license;
+
+			const char*									_fileName;
+			int											_lineNumber;
+			int											_errors;
+
+			// Sequences are only added, so the pointer to the last one stays valid until the next is started.
+			std::vector<Sequence>						_sequences;
+			Sequence*									_current;
+			bool										_inRepeat;
+	};
+
+	const char* Compiler::license =
+		"/*\n"
+		"\tCopyright (c) 2019 Lance A. Endres\n"
+		"\n"
+		"\tThis program is free software: you can redistribute it and/or modify\n"
+		"\tit under the terms of the Attribution-NonCommercial 4.0 International\n"
+		"\t(CC BY-NC 4.0) license as published by the Creative Commons Corporation\n"
+		"\tor (at your option) any later version.\n"
+		"\n"
+		"\tYou may not use this software for commercial works or profit from it.\n"
+		"\t\n"
+		"\tThis program is distributed in the hope that it will be useful,\n"
+		"\tbut WITHOUT ANY WARRANTY; without even the implied warranty of\n"
+		"\tMERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n"
+		"\n"
+		"\thttps://creativecommons.org/licenses/by-nc/4.0/legalcode\n"
+		"*/\n";
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s input output\n", argv[0]);
+		return 1;
+	}
+
+	FILE* input = fopen(argv[1], "r");
+	if (input == nullptr)
+	{
+		fprintf(stderr, "Unable to open \"%s\".\n", argv[1]);
+		return 1;
+	}
+
+	Compiler compiler(argv[1]);
+	bool result = compiler.compile(input);
+	fclose(input);
+
+	if (!result)
+	{
+		return 1;
+	}
+
+	FILE* output = fopen(argv[2], "w");
+	if (output == nullptr)
+	{
+		fprintf(stderr, "Unable to create \"%s\".\n", argv[2]);
+		return 1;
+	}
+
+	compiler.write(output);
+	fclose(output);
+
+	return 0;
+}
@@ -0,0 +1,731 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "SimulatedHardware.h"
+#include "SoftwareSerial.h"
+#include <stdio.h>
+
+SimulatedSerial::SimulatedSerial() :
+	_baud(0),
+	_echo(false),
+	_capture(nullptr),
+	_receivedPosition(0),
+	_bytesQueued(0),
+	_drainTime(0),
+	_bytesWritten(0),
+	_blockedMicroseconds(0)
+{
+}
+
+void SimulatedSerial::begin(unsigned long baud)
+{
+	_baud			= baud;
+	_bytesQueued	= 0;
+	_drainTime		= SimulatedHardware::instance().getTime();
+}
+
+void SimulatedSerial::setEcho(bool echo)
+{
+	_echo = echo;
+}
+
+void SimulatedSerial::setCapture(FILE* file)
+{
+	_capture = file;
+}
+
+size_t SimulatedSerial::write(uint8_t value)
+{
+	// Like the hardware port, nothing goes out until the port has been started.
+	if (_baud == 0)
+	{
+		return 0;
+	}
+
+	drain();
+
+	// A full buffer blocks until the next byte has been sent.  One start, eight data and one stop bit per byte.
+	if (_bytesQueued == nSimulatedSerialBuffer)
+	{
+		uint64_t byteTime = 10000000UL / _baud;
+		SimulatedHardware::instance().advance(byteTime);
+		_blockedMicroseconds += byteTime;
+		drain();
+	}
+
+	_bytesQueued++;
+	_bytesWritten++;
+
+	if (_echo)
+	{
+		putchar(value);
+	}
+
+	if (_capture != nullptr)
+	{
+		fputc(value, _capture);
+	}
+
+	return 1;
+}
+
+int SimulatedSerial::availableForWrite()
+{
+	if (_baud == 0)
+	{
+		return 0;
+	}
+
+	drain();
+	return nSimulatedSerialBuffer - _bytesQueued;
+}
+
+size_t SimulatedSerial::print(const char message[])
+{
+	size_t count = 0;
+	while (message[count] != '\0')
+	{
+		write(message[count]);
+		count++;
+	}
+	return count;
+}
+
+size_t SimulatedSerial::print(char message)
+{
+	return write(message);
+}
+
+size_t SimulatedSerial::print(int message)
+{
+	return print((long)message);
+}
+
+size_t SimulatedSerial::print(unsigned int message)
+{
+	return print((unsigned long)message);
+}
+
+size_t SimulatedSerial::print(long message)
+{
+	char buffer[24];
+	snprintf(buffer, sizeof(buffer), "%ld", message);
+	return print(buffer);
+}
+
+size_t SimulatedSerial::print(unsigned long message)
+{
+	char buffer[24];
+	snprintf(buffer, sizeof(buffer), "%lu", message);
+	return print(buffer);
+}
+
+int SimulatedSerial::available()
+{
+	return _received.size() - _receivedPosition;
+}
+
+int SimulatedSerial::read()
+{
+	if (_receivedPosition == _received.size())
+	{
+		return -1;
+	}
+
+	return (uint8_t)_received[_receivedPosition++];
+}
+
+void SimulatedSerial::receive(const char text[])
+{
+	_received.erase(0, _receivedPosition);
+	_received			+= text;
+	_receivedPosition	= 0;
+}
+
+unsigned long SimulatedSerial::getBytesWritten()
+{
+	return _bytesWritten;
+}
+
+unsigned long SimulatedSerial::getBlockedMicroseconds()
+{
+	return _blockedMicroseconds;
+}
+
+void SimulatedSerial::resetCounters()
+{
+	_bytesWritten			= 0;
+	_blockedMicroseconds	= 0;
+}
+
+void SimulatedSerial::drain()
+{
+	uint64_t now		= SimulatedHardware::instance().getTime();
+	uint64_t byteTime	= 10000000UL / _baud;
+	uint64_t sent		= (now - _drainTime) / byteTime;
+
+	if (sent >= _bytesQueued)
+	{
+		_bytesQueued	= 0;
+		_drainTime		= now;
+	}
+	else
+	{
+		_bytesQueued   -= sent;
+		_drainTime	   += sent*byteTime;
+	}
+}
+
+SimulatedAudioBoard::SimulatedAudioBoard() :
+	_serial(nullptr),
+	_byteTime(0),
+	_replyTime(simulatedAudioReplyTime),
+	_fileTime(simulatedAudioFileTime),
+	_playing(false),
+	_fileEndTime(0),
+	_playTime(0),
+	_startTime(0),
+	_commands(0),
+	_filesStarted(0),
+	_filesReplaced(0),
+	_filesFinished(0)
+{
+}
+
+void SimulatedAudioBoard::connect(SoftwareSerial* serial, long baud)
+{
+	_serial		= serial;
+	_byteTime	= 10000000UL / baud;
+}
+
+void SimulatedAudioBoard::receive(uint8_t value)
+{
+	if (value == '\n')
+	{
+		runCommand(SimulatedHardware::instance().getTime());
+		_command.clear();
+	}
+	else if (value != '\r')
+	{
+		_command += (char)value;
+	}
+}
+
+void SimulatedAudioBoard::deliver()
+{
+	if (_serial == nullptr)
+	{
+		return;
+	}
+
+	uint64_t now = SimulatedHardware::instance().getTime();
+	finishFile(now);
+
+	while (!_replies.empty() && _replies.front().time <= now)
+	{
+		_serial->receive(_replies.front().value);
+		_replies.pop_front();
+	}
+}
+
+void SimulatedAudioBoard::setReplyTime(unsigned long replyTime)
+{
+	_replyTime = replyTime;
+}
+
+void SimulatedAudioBoard::setFileTime(unsigned long fileTime)
+{
+	_fileTime = fileTime;
+}
+
+const std::string& SimulatedAudioBoard::getLastFile()
+{
+	return _file;
+}
+
+uint64_t SimulatedAudioBoard::getLastPlayTime()
+{
+	return _playTime;
+}
+
+uint64_t SimulatedAudioBoard::getLastStartTime()
+{
+	return _startTime;
+}
+
+unsigned long SimulatedAudioBoard::getCommands()
+{
+	return _commands;
+}
+
+unsigned long SimulatedAudioBoard::getFilesStarted()
+{
+	return _filesStarted;
+}
+
+unsigned long SimulatedAudioBoard::getFilesReplaced()
+{
+	return _filesReplaced;
+}
+
+unsigned long SimulatedAudioBoard::getFilesFinished()
+{
+	return _filesFinished;
+}
+
+void SimulatedAudioBoard::resetCounters()
+{
+	_commands		= 0;
+	_filesStarted	= 0;
+	_filesReplaced	= 0;
+	_filesFinished	= 0;
+}
+
+void SimulatedAudioBoard::runCommand(uint64_t now)
+{
+	// A file that ended before the command came in has already said so.
+	finishFile(now);
+
+	if (_command.empty())
+	{
+		return;
+	}
+	_commands++;
+
+	switch (_command[0])
+	{
+		case 'P':
+		{
+			// Starting a file stops the one playing without a "done".
+			if (_playing)
+			{
+				_filesReplaced++;
+			}
+			_file		= _command.substr(1);
+			_playTime	= now;
+
+			size_t track = 0;
+			while (track < _tracks.size() && _tracks[track] != _file)
+			{
+				track++;
+			}
+			if (track == _tracks.size())
+			{
+				_tracks.push_back(_file);
+			}
+
+			// The answer goes out as the file starts.
+			_startTime		= reply("play\t" + std::to_string(track) + "\t" + _file + "\r\n", now + _replyTime);
+			_playing		= true;
+			_fileEndTime	= _startTime + _fileTime;
+			_filesStarted++;
+			break;
+		}
+
+		default:
+		{
+			break;
+		}
+	}
+}
+
+// Answers go out one after the other, so one that is ready while another is being sent waits its turn.  Returns the
+// time the answer started going out.
+uint64_t SimulatedAudioBoard::reply(const std::string& text, uint64_t time)
+{
+	if (!_replies.empty() && _replies.back().time + _byteTime > time)
+	{
+		time = _replies.back().time + _byteTime;
+	}
+
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		_replies.push_back({time + (i+1)*_byteTime, (uint8_t)text[i]});
+	}
+
+	return time;
+}
+
+void SimulatedAudioBoard::finishFile(uint64_t now)
+{
+	if (_playing && _fileEndTime <= now)
+	{
+		_playing = false;
+		_filesFinished++;
+		reply("done\r\n", _fileEndTime);
+	}
+}
+
+SimulatedHardware& SimulatedHardware::instance()
+{
+	static SimulatedHardware hardware;
+	return hardware;
+}
+
+SimulatedHardware::SimulatedHardware()
+{
+	reset();
+}
+
+void SimulatedHardware::reset()
+{
+	_time				= 0;
+	_interruptsEnabled	= true;
+	_inInterrupt		= false;
+
+	for (int i = 0; i < NUMBEROFTIMERS; i++)
+	{
+		_timers[i].handler	= nullptr;
+		_timers[i].period	= 0;
+		_timers[i].deadline	= 0;
+	}
+
+	for (int i = 0; i < nSimulatedPins; i++)
+	{
+		_pinMode[i]			= INPUT;
+		_pinOutput[i]		= LOW;
+		_pinDriven[i]		= false;
+		_pinDrivenLevel[i]	= LOW;
+		_analogInput[i]		= 0;
+	}
+
+	_analogNoise			= 0;
+	_analogNoiseState		= 1;
+	_analogSamplePin		= 0;
+	_analogSampleHandler	= nullptr;
+
+	_shiftRegisterOutput		= 0;
+	_shiftRegisterChangeTime	= 0;
+	for (int i = 0; i < 32; i++)
+	{
+		_shiftRegisterOutputChangeTime[i] = 0;
+	}
+	_serial = SimulatedSerial();
+	_audioBoard = SimulatedAudioBoard();
+	resetCounters();
+}
+
+unsigned long SimulatedHardware::millis()
+{
+	return _time / 1000;
+}
+
+unsigned long SimulatedHardware::micros()
+{
+	return _time;
+}
+
+uint64_t SimulatedHardware::getTime()
+{
+	return _time;
+}
+
+void SimulatedHardware::advance(uint64_t microseconds)
+{
+	// Time spent inside an interrupt handler, or with interrupts disabled, just adds to the clock.
+	if (_inInterrupt || !_interruptsEnabled)
+	{
+		_time += microseconds;
+		return;
+	}
+
+	uint64_t end = _time + microseconds;
+
+	while (true)
+	{
+		Timer* timer = nullptr;
+		for (int i = 0; i < NUMBEROFTIMERS; i++)
+		{
+			if (_timers[i].handler != nullptr && (timer == nullptr || _timers[i].deadline < timer->deadline))
+			{
+				timer = &_timers[i];
+			}
+		}
+
+		if (timer == nullptr || timer->deadline > end)
+		{
+			break;
+		}
+
+		if (timer->deadline > _time)
+		{
+			_time = timer->deadline;
+		}
+
+		uint64_t start = _time;
+
+		_inInterrupt = true;
+		timer->handler();
+		_inInterrupt = false;
+
+		// The interrupted code finishes later by however long the handler took.  If the handler ran past its next
+		// deadline, the interrupt fires again right away, but the interrupted code gets to run a little in between (one
+		// instruction on the AVR).
+		uint64_t handlerTime	= _time - start;
+		end					   += handlerTime;
+		timer->deadline		   += timer->period;
+		if (timer->deadline <= _time)
+		{
+			timer->deadline = _time + 1;
+		}
+
+		_counters.interrupts++;
+		_counters.interruptMicroseconds += handlerTime;
+	}
+
+	_time = end;
+}
+
+void SimulatedHardware::startTimer(TIMER timer, void (*handler)(), unsigned long period)
+{
+	_timers[timer].handler	= handler;
+	_timers[timer].period	= period;
+	_timers[timer].deadline	= _time + period;
+}
+
+void SimulatedHardware::setTimerPeriod(TIMER timer, unsigned long period)
+{
+	_timers[timer].period = period;
+}
+
+void SimulatedHardware::sleep()
+{
+	// With interrupts disabled the AVR would never wake up.  Carry on instead, so the run can still be looked at.
+	if (_inInterrupt || !_interruptsEnabled)
+	{
+		return;
+	}
+
+	Timer* timer = nullptr;
+	for (int i = 0; i < NUMBEROFTIMERS; i++)
+	{
+		if (_timers[i].handler != nullptr && (timer == nullptr || _timers[i].deadline < timer->deadline))
+		{
+			timer = &_timers[i];
+		}
+	}
+
+	if (timer == nullptr)
+	{
+		return;
+	}
+
+	// Asleep until the interrupt, awake while it runs.
+	if (timer->deadline > _time)
+	{
+		_counters.sleeps++;
+		_counters.sleepMicroseconds += timer->deadline - _time;
+		advance(timer->deadline - _time);
+	}
+	else
+	{
+		advance(0);
+	}
+}
+
+void SimulatedHardware::disableInterrupts()
+{
+	_interruptsEnabled = false;
+}
+
+void SimulatedHardware::enableInterrupts()
+{
+	_interruptsEnabled = true;
+
+	// Run anything that came due while they were disabled.
+	advance(0);
+}
+
+void SimulatedHardware::pinMode(uint8_t pin, uint8_t mode)
+{
+	// Like the AVR, INPUT_PULLUP is an input with the output latch (pull up) set high.
+	if (mode == INPUT_PULLUP)
+	{
+		_pinMode[pin]	= INPUT;
+		_pinOutput[pin]	= HIGH;
+	}
+	else
+	{
+		_pinMode[pin]	= mode;
+	}
+}
+
+int SimulatedHardware::digitalRead(uint8_t pin)
+{
+	_counters.digitalReads++;
+	advance(simulatedDigitalReadTime);
+
+	if (_pinMode[pin] == OUTPUT)
+	{
+		return _pinOutput[pin];
+	}
+
+	if (_pinDriven[pin])
+	{
+		return _pinDrivenLevel[pin];
+	}
+
+	// Released input.  Writing high to an input turns on the pull up.
+	return _pinOutput[pin];
+}
+
+void SimulatedHardware::digitalWrite(uint8_t pin, uint8_t value)
+{
+	_counters.digitalWrites++;
+	advance(simulatedDigitalWriteTime);
+	_pinOutput[pin] = value ? HIGH : LOW;
+}
+
+int SimulatedHardware::analogRead(uint8_t pin)
+{
+	_counters.analogReads++;
+	advance(simulatedAnalogReadTime);
+	return _analogInput[pin];
+}
+
+void SimulatedHardware::driveInput(uint8_t pin, uint8_t level)
+{
+	_pinDriven[pin]			= true;
+	_pinDrivenLevel[pin]	= level ? HIGH : LOW;
+}
+
+void SimulatedHardware::releaseInput(uint8_t pin)
+{
+	_pinDriven[pin] = false;
+}
+
+void SimulatedHardware::setAnalogInput(uint8_t pin, int value)
+{
+	_analogInput[pin] = value;
+}
+
+void SimulatedHardware::setAnalogNoise(int amplitude)
+{
+	_analogNoise = amplitude;
+}
+
+void SimulatedHardware::startAnalogSampling(uint8_t pin, void (*handler)(uint16_t value), unsigned long period)
+{
+	_analogSamplePin		= pin;
+	_analogSampleHandler	= handler;
+	startTimer(ADCCONVERSION, analogConversionComplete, period);
+}
+
+void SimulatedHardware::analogConversionComplete()
+{
+	SimulatedHardware& hardware = instance();
+	hardware._counters.analogConversions++;
+
+	int value = hardware._analogInput[hardware._analogSamplePin];
+
+	if (hardware._analogNoise > 0)
+	{
+		// Xorshift, so runs are repeatable on every platform.
+		hardware._analogNoiseState ^= hardware._analogNoiseState << 13;
+		hardware._analogNoiseState ^= hardware._analogNoiseState >> 17;
+		hardware._analogNoiseState ^= hardware._analogNoiseState << 5;
+		value += (int)(hardware._analogNoiseState % (uint32_t)(2*hardware._analogNoise + 1)) - hardware._analogNoise;
+	}
+
+	value = value < 0 ? 0 : value > 1023 ? 1023 : value;
+	hardware._analogSampleHandler((uint16_t)value);
+}
+
+uint8_t SimulatedHardware::getOutput(uint8_t pin)
+{
+	return _pinOutput[pin];
+}
+
+void SimulatedHardware::latchShiftRegisters(const uint8_t values[], uint8_t numberOfShiftRegisters, unsigned long microseconds)
+{
+	// The outputs change when the latch pin is toggled at the end.
+	advance(microseconds);
+	_counters.shiftRegisterMicroseconds += microseconds;
+
+	uint32_t output = 0;
+	for (int i = 0; i < numberOfShiftRegisters && i < 4; i++)
+	{
+		output |= (uint32_t)values[i] << (8*i);
+	}
+
+	if (output != _shiftRegisterOutput)
+	{
+		for (int i = 0; i < 32; i++)
+		{
+			if (((output ^ _shiftRegisterOutput) >> i) & 1)
+			{
+				_shiftRegisterOutputChangeTime[i] = _time;
+			}
+		}
+
+		_shiftRegisterOutput		= output;
+		_shiftRegisterChangeTime	= _time;
+		_counters.shiftRegisterChanges++;
+	}
+
+	_counters.shiftRegisterLatches++;
+	_counters.shiftRegisterBits += 8*numberOfShiftRegisters;
+}
+
+uint32_t SimulatedHardware::getShiftRegisterOutput()
+{
+	return _shiftRegisterOutput;
+}
+
+uint64_t SimulatedHardware::getShiftRegisterChangeTime()
+{
+	return _shiftRegisterChangeTime;
+}
+
+uint64_t SimulatedHardware::getShiftRegisterChangeTime(uint8_t output)
+{
+	return _shiftRegisterOutputChangeTime[output];
+}
+
+SimulatedSerial& SimulatedHardware::getSerial()
+{
+	return _serial;
+}
+
+SimulatedAudioBoard& SimulatedHardware::getAudioBoard()
+{
+	return _audioBoard;
+}
+
+const SimulatedHardware::Counters& SimulatedHardware::getCounters()
+{
+	return _counters;
+}
+
+void SimulatedHardware::resetCounters()
+{
+	_counters.digitalReads				= 0;
+	_counters.digitalWrites				= 0;
+	_counters.analogReads				= 0;
+	_counters.analogConversions			= 0;
+	_counters.shiftRegisterLatches		= 0;
+	_counters.shiftRegisterBits			= 0;
+	_counters.shiftRegisterChanges		= 0;
+	_counters.shiftRegisterMicroseconds	= 0;
+	_counters.interrupts				= 0;
+	_counters.interruptMicroseconds		= 0;
+	_counters.sleeps					= 0;
+	_counters.sleepMicroseconds			= 0;
+	_serial.resetCounters();
+	_audioBoard.resetCounters();
+}
@@ -0,0 +1,445 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef SIMULATEDHARDWARE_H
+#define SIMULATEDHARDWARE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string>
+#include <deque>
+#include <vector>
+
+// Arduino core constants used by the sketch.
+#define LOW								0x0
+#define HIGH							0x1
+
+#define INPUT							0x0
+#define OUTPUT							0x1
+#define INPUT_PULLUP					0x2
+
+// The host has a single address space, so tables the sketch keeps in flash are just constant data.
+#define PROGMEM
+
+// Strings marked with F() are kept in flash on the AVR and printed through a pointer to this type.
+class __FlashStringHelper;
+#define F(string)						(reinterpret_cast<const __FlashStringHelper*>(string))
+
+// Pin numbering follows the Arduino Uno.
+#define nSimulatedPins					20
+
+static const uint8_t A0					= 14;
+static const uint8_t A1					= 15;
+static const uint8_t A2					= 16;
+static const uint8_t A3					= 17;
+static const uint8_t A4					= 18;
+static const uint8_t A5					= 19;
+
+// Time the Arduino core takes for the pin functions on a 16 MHz AVR.
+#define simulatedDigitalReadTime		3
+#define simulatedDigitalWriteTime		4
+#define simulatedAnalogReadTime			112
+
+// Supply current (milliamps) of the processor (ATmega328P at 16 MHz and 5 volts) awake and in idle sleep.
+#define simulatedActiveCurrent			9.0
+#define simulatedIdleCurrent			2.6
+
+// Time it takes to shift out one register.  Bit banging (the ShiftRegister74HC595 library) is about 7 microseconds a bit.
+// The SPI peripheral at 8 MHz is about 2 microseconds a byte, including overhead.  Toggling the latch pin costs the same
+// either way.
+#define simulatedBitBangRegisterTime	56
+#define simulatedSpiRegisterTime		2
+#define simulatedLatchTime				8
+
+// Size of the hardware serial transmit buffer on the Uno.
+#define nSimulatedSerialBuffer			64
+
+// Time (microseconds) the audio board takes to start a file (opening it on the SD card), whether it was asked over the
+// serial port or with a trigger line, and the length of the files it plays.
+#define simulatedAudioReplyTime			20000
+#define simulatedAudioFileTime			1500000
+
+// The debug serial port.  Transmitting is modeled the same way as the Arduino hardware serial port: bytes go into a
+// transmit buffer that empties at the baud rate and writing to a full buffer blocks (advances the clock) until there is
+// room.  Output is only echoed to the console (or captured to a file) when requested.  Received bytes are injected by
+// the simulation.
+class SimulatedSerial
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		SimulatedSerial();
+
+	// Public interface.
+	public:
+		void begin(unsigned long baud);
+
+		void setEcho(bool echo);
+		void setCapture(FILE* file);
+
+		size_t write(uint8_t value);
+
+		// Free space in the transmit buffer.  Writing this many bytes does not block.
+		int availableForWrite();
+
+		size_t print(const char message[]);
+		size_t print(char message);
+		size_t print(int message);
+		size_t print(unsigned int message);
+		size_t print(long message);
+		size_t print(unsigned long message);
+
+		template<typename T> size_t println(T message)
+		{
+			size_t count = print(message);
+			return count + print("\r\n");
+		}
+
+		// Receiving (used by the sketch).
+		int available();
+		int read();
+
+		// Receiving (used by the simulation).  The text is available to read right away.
+		void receive(const char text[]);
+
+		// Statistics.
+		unsigned long getBytesWritten();
+		unsigned long getBlockedMicroseconds();
+		void resetCounters();
+
+	private:
+		void drain();
+
+	private:
+		unsigned long									_baud;
+		bool											_echo;
+		FILE*											_capture;
+
+		std::string										_received;
+		size_t											_receivedPosition;
+
+		// Bytes waiting in the transmit buffer and the time it was last emptied to.
+		unsigned long									_bytesQueued;
+		uint64_t										_drainTime;
+
+		unsigned long									_bytesWritten;
+		unsigned long									_blockedMicroseconds;
+};
+
+class SoftwareSerial;
+
+// The audio board (VS1000 in UART mode) on the other end of the audio serial port.  It reads the command lines the
+// sketch sends and answers them like the real board: "P<file>" with "play <track> <file>" (replacing any file that was
+// playing), and a file that plays to the end with "done".  The answers arrive a byte at a time at the baud rate.  They
+// are handed to the serial port when the sketch looks for them, which is the same as the real port receiving them in
+// its interrupt.
+class SimulatedAudioBoard
+{
+	// Constructors.
+	public:
+		// Default contstructor.
+		SimulatedAudioBoard();
+
+	// Public interface.
+	public:
+		// Serial port (used by SoftwareSerial).
+		void connect(SoftwareSerial* serial, long baud);
+		void receive(uint8_t value);
+		void deliver();
+
+		// How long the board takes to answer a command, and how long the files play (microseconds).  A reply time longer
+		// than the sketch's reply timeout makes every command time out.
+		void setReplyTime(unsigned long replyTime);
+		void setFileTime(unsigned long fileTime);
+
+		// The last file the sketch asked for, when the command finished arriving, and when the file started playing.
+		const std::string& getLastFile();
+		uint64_t getLastPlayTime();
+		uint64_t getLastStartTime();
+
+		// Statistics.
+		unsigned long getCommands();
+		unsigned long getFilesStarted();
+		unsigned long getFilesReplaced();
+		unsigned long getFilesFinished();
+		void resetCounters();
+
+	private:
+		void runCommand(uint64_t now);
+		uint64_t reply(const std::string& text, uint64_t time);
+		void finishFile(uint64_t now);
+
+	private:
+		SoftwareSerial*									_serial;
+		uint64_t										_byteTime;
+		unsigned long									_replyTime;
+		unsigned long									_fileTime;
+
+		// The command line being received and the bytes of the answers, with the time each one arrives.
+		std::string										_command;
+
+		struct TimedByte
+		{
+			uint64_t									time;
+			uint8_t										value;
+		};
+
+		std::deque<TimedByte>							_replies;
+
+		// The file playing, the track numbers handed out so far, and when the file ends.
+		bool											_playing;
+		std::string										_file;
+		std::vector<std::string>						_tracks;
+		uint64_t										_fileEndTime;
+		uint64_t										_playTime;
+		uint64_t										_startTime;
+
+		unsigned long									_commands;
+		unsigned long									_filesStarted;
+		unsigned long									_filesReplaced;
+		unsigned long									_filesFinished;
+};
+
+// The simulated microcontroller.  Provides a virtual clock, pins that can be driven from the simulation, the debug
+// serial port, and a record of what was latched into the output shift registers.
+//
+// The virtual clock only moves when it is advanced, either by the simulation (to account for the time a loop takes) or
+// by something that blocks (delay, serial writes).  Unlike the Arduino, millis and micros do not roll over.
+class SimulatedHardware
+{
+	// Constructors.
+	public:
+		// There is only one microcontroller.
+		static SimulatedHardware& instance();
+
+	// Public interface.
+	public:
+		// Put everything back to the power on state.
+		void reset();
+
+		// Virtual clock.
+		unsigned long millis();
+		unsigned long micros();
+		uint64_t getTime();
+		void advance(uint64_t microseconds);
+
+		// Periodic interrupts, named after the AVR timers they stand in for (and the ADC, whose conversions are triggered
+		// by Timer0).  A handler runs whenever the clock is advanced past its deadline and interrupts are enabled.  Time
+		// spent in the handler delays the code that was interrupted.  When two are due at once, the one listed first runs
+		// first (the AVR gives Timer2 priority over Timer0, and Timer0 over the ADC).
+		enum TIMER
+		{
+			TIMER2,
+			TIMER0,
+			ADCCONVERSION,
+			NUMBEROFTIMERS
+		};
+
+		void startTimer(TIMER timer, void (*handler)(), unsigned long period);
+		void setTimerPeriod(TIMER timer, unsigned long period);
+
+		// Background conversions of an analog pin, handed to "handler" every "period" microseconds.  The value is the
+		// analog input of the pin plus the noise.
+		void startAnalogSampling(uint8_t pin, void (*handler)(uint16_t value), unsigned long period);
+
+		// Sleep until the next interrupt and run it.  Returns straight away if there is nothing to wake up for.
+		void sleep();
+
+		// Interrupts that come due while disabled run as soon as they are enabled again.
+		void disableInterrupts();
+		void enableInterrupts();
+
+		// Pins (used by the sketch).
+		void pinMode(uint8_t pin, uint8_t mode);
+		int digitalRead(uint8_t pin);
+		void digitalWrite(uint8_t pin, uint8_t value);
+		int analogRead(uint8_t pin);
+
+		// Pins (used by the simulation).  An input that is driven reads the driven level.  An input that is released
+		// reads high if its pull up resistor is enabled and low otherwise.
+		void driveInput(uint8_t pin, uint8_t level);
+		void releaseInput(uint8_t pin);
+		void setAnalogInput(uint8_t pin, int value);
+
+		// Random noise (up to plus or minus "amplitude") added to every analog conversion, like a real ADC on a board with
+		// switching loads.
+		void setAnalogNoise(int amplitude);
+		uint8_t getOutput(uint8_t pin);
+
+		// Output shift registers.  Called every time the registers are latched.  The clock is advanced by the time it
+		// took to shift the values out.
+		void latchShiftRegisters(const uint8_t values[], uint8_t numberOfShiftRegisters, unsigned long microseconds);
+		uint32_t getShiftRegisterOutput();
+
+		// The last time a latch changed the outputs, or changed a single output.
+		uint64_t getShiftRegisterChangeTime();
+		uint64_t getShiftRegisterChangeTime(uint8_t output);
+
+		SimulatedSerial& getSerial();
+		SimulatedAudioBoard& getAudioBoard();
+
+		// Number of calls made into the hardware since the last reset of the counters.
+		struct Counters
+		{
+			unsigned long								digitalReads;
+			unsigned long								digitalWrites;
+			unsigned long								analogReads;
+			unsigned long								analogConversions;
+			unsigned long								shiftRegisterLatches;
+			unsigned long								shiftRegisterBits;
+			unsigned long								shiftRegisterChanges;
+			unsigned long								shiftRegisterMicroseconds;
+			unsigned long								interrupts;
+			unsigned long								interruptMicroseconds;
+			unsigned long								sleeps;
+			uint64_t									sleepMicroseconds;
+		};
+
+		const Counters& getCounters();
+		void resetCounters();
+
+	private:
+		SimulatedHardware();
+
+	private:
+		uint64_t										_time;
+
+		struct Timer
+		{
+			void										(*handler)();
+			unsigned long								period;
+			uint64_t									deadline;
+		};
+
+		Timer											_timers[NUMBEROFTIMERS];
+		bool											_interruptsEnabled;
+		bool											_inInterrupt;
+
+		uint8_t											_pinMode[nSimulatedPins];
+		uint8_t											_pinOutput[nSimulatedPins];
+		bool											_pinDriven[nSimulatedPins];
+		uint8_t											_pinDrivenLevel[nSimulatedPins];
+		int												_analogInput[nSimulatedPins];
+		int												_analogNoise;
+		uint32_t										_analogNoiseState;
+
+		// Background conversions.
+		static void analogConversionComplete();
+		uint8_t											_analogSamplePin;
+		void											(*_analogSampleHandler)(uint16_t value);
+
+		uint32_t										_shiftRegisterOutput;
+		uint64_t										_shiftRegisterChangeTime;
+		uint64_t										_shiftRegisterOutputChangeTime[32];
+
+		SimulatedSerial									_serial;
+		SimulatedAudioBoard								_audioBoard;
+
+		Counters										_counters;
+};
+
+// Replacement for the ShiftRegister74HC595 library (or SpiShiftRegister when "hardwareSpi" is true).  Keeps the same
+// interface, but instead of shifting the bits out, latching hands them to the simulated hardware along with the time
+// the real backend would have taken.
+template<uint8_t numberOfShiftRegisters, bool hardwareSpi = false> class SimulatedShiftRegister
+{
+	// Constructors.
+	public:
+		SimulatedShiftRegister(int serialDataPin, int clockPin, int latchPin) :
+			_serialDataPin(serialDataPin),
+			_clockPin(clockPin),
+			_latchPin(latchPin)
+		{
+			for (int i = 0; i < numberOfShiftRegisters; i++)
+			{
+				_digitalValues[i] = 0;
+			}
+		}
+
+	// Public interface.
+	public:
+		void setAll(const uint8_t* digitalValues)
+		{
+			for (int i = 0; i < numberOfShiftRegisters; i++)
+			{
+				_digitalValues[i] = digitalValues[i];
+			}
+			updateRegisters();
+		}
+
+		uint8_t* getAll()
+		{
+			return _digitalValues;
+		}
+
+		void set(const uint8_t pin, const uint8_t value)
+		{
+			setNoUpdate(pin, value);
+			updateRegisters();
+		}
+
+		void setNoUpdate(const uint8_t pin, const uint8_t value)
+		{
+			if (value == 1)
+			{
+				_digitalValues[pin / 8] |= 1 << (pin % 8);
+			}
+			else
+			{
+				_digitalValues[pin / 8] &= ~(1 << (pin % 8));
+			}
+		}
+
+		uint8_t get(const uint8_t pin)
+		{
+			return (_digitalValues[pin / 8] >> (pin % 8)) & 1;
+		}
+
+		void updateRegisters()
+		{
+			unsigned long registerTime = hardwareSpi ? simulatedSpiRegisterTime : simulatedBitBangRegisterTime;
+			SimulatedHardware::instance().latchShiftRegisters(_digitalValues, numberOfShiftRegisters, numberOfShiftRegisters*registerTime + simulatedLatchTime);
+		}
+
+		void setAllLow()
+		{
+			for (int i = 0; i < numberOfShiftRegisters; i++)
+			{
+				_digitalValues[i] = 0;
+			}
+			updateRegisters();
+		}
+
+		void setAllHigh()
+		{
+			for (int i = 0; i < numberOfShiftRegisters; i++)
+			{
+				_digitalValues[i] = 0xFF;
+			}
+			updateRegisters();
+		}
+
+	private:
+		int												_serialDataPin;
+		int												_clockPin;
+		int												_latchPin;
+		uint8_t											_digitalValues[numberOfShiftRegisters];
+};
+
+#endif
@@ -0,0 +1,617 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+/*
+	Runs the generator on the simulated hardware.  An "operator" randomly moves the arm through its positions and pushes
+	the mode and overload buttons while the generator loop runs against the virtual clock.  At the end, a summary of the
+	work done by the generator is printed.
+
+	Usage:
+		NaquadahSimulator [--hours hours] [--step microseconds] [--seed seed] [--record file] [--serial] [--noise counts]
+			[--battery milliamp-hours] [--load milliamps] [--audio-reply milliseconds] [--bounce microseconds]
+			[--glitches count]
+
+		--hours		Simulated time to run for (default 1).
+		--step		Virtual time each pass through the loop takes (default 100 microseconds).
+		--seed		Seed for the operator's random actions (default 1).
+		--record	Write the operator's actions to a timeline file that can be replayed with NaquadahReplay.
+		--serial	Echo the generator's debug serial output to the console.
+		--noise		Random noise (plus or minus counts) added to the battery voltage conversions (default 0).
+		--battery	Battery capacity used to estimate the run time (default 2000 milliamp-hours).
+		--load		Current drawn by everything but the processor, e.g. lights and audio (default 15 milliamps).
+		--audio-reply	Time the audio board takes to answer a command (default 20 milliseconds).  Longer than the
+					reply timeout in the configuration makes every command time out.
+		--bounce	Time the sensors and buttons chatter each time they make or break contact (default 0).
+		--glitches	Number of times an hour noise makes the sensors read as another position for a moment (default 0).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Timeline.h"
+#include "LightPatterns.h"
+
+// Generates the operator's actions one cycle (off, up to on, and back to off) at a time.
+class Operator
+{
+	public:
+		// The sensors and buttons chatter for "bounce" microseconds each time they make or break contact.  "Glitches" is
+		// the number of times an hour noise makes the sensors read as another position for a moment.
+		Operator(Configuration& configuration, unsigned long seed, unsigned long bounce, unsigned long glitches) :
+			_configuration(configuration),
+			_random(seed ? seed : 1),
+			_bounce(bounce),
+			_glitches(glitches),
+			_nextEvent(0),
+			_nextGlitch(0),
+			_position(GENERATOR::OFF),
+			_plannedPosition(GENERATOR::OFF)
+		{
+		}
+
+		// Applies every action that is due and records it if a file is given.  Returns the number of arm positions
+		// reached.
+		int update(uint64_t now, FILE* recordFile)
+		{
+			int armMoves = 0;
+
+			if (_nextEvent == _cycle.size() && _nextGlitch == _glitchEvents.size())
+			{
+				_cycle.clear();
+				_glitchEvents.clear();
+				_nextEvent	= 0;
+				_nextGlitch	= 0;
+				planCycle(now);
+			}
+
+			while (true)
+			{
+				// The glitches are kept apart so they are not counted as the arm moving.
+				bool glitchFirst	= _nextGlitch < _glitchEvents.size() && (_nextEvent == _cycle.size() || _glitchEvents[_nextGlitch].time < _cycle[_nextEvent].time);
+				const Timeline&	list	= glitchFirst ? _glitchEvents : _cycle;
+				size_t&			next	= glitchFirst ? _nextGlitch : _nextEvent;
+
+				if (next == list.size() || list[next].time > now)
+				{
+					break;
+				}
+
+				const TimelineEvent& event = list[next++];
+
+				Timeline::apply(event, _configuration);
+
+				if (recordFile != nullptr)
+				{
+					Timeline::write(recordFile, event);
+				}
+
+				// A sensor chattering where the arm already is doesn't count as reaching a position.
+				if (!glitchFirst && event.action == TIMELINE::ARM && event.value != _position)
+				{
+					_position = event.value;
+					armMoves++;
+				}
+			}
+
+			return armMoves;
+		}
+
+	private:
+		void planCycle(uint64_t time)
+		{
+			const uint64_t second	= 1000000;
+			uint64_t start			= time;
+			int position			= _plannedPosition;
+
+			// Sitting in off, step through some of the special modes.
+			int presses = random(GENERATOR::NUMBEROFSPECIALMODES);
+			for (int i = 0; i < presses; i++)
+			{
+				pushButton(time, TIMELINE::MODEBUTTON);
+				time += 3*second;
+			}
+			time += (5 + random(25))*second;
+
+			// Up to on.
+			for (int state = GENERATOR::PRIMED0; state <= GENERATOR::ON; state++)
+			{
+				time = moveArm(time, state);
+
+				if (state == GENERATOR::ON)
+				{
+					// Play with the overload button for a while, sometimes all the way to full overload.
+					int overloads = random(GENERATOR::NUMBEROFSPECIALMODES + 1);
+					for (int i = 0; i < overloads; i++)
+					{
+						time += (2 + random(10))*second;
+						pushButton(time, TIMELINE::MODEBUTTON);
+					}
+					time += (20 + random(100))*second;
+				}
+				else
+				{
+					time += (1 + random(3))*second;
+				}
+			}
+
+			// Back down to off.
+			for (int state = GENERATOR::PRIMED1; state >= GENERATOR::OFF; state--)
+			{
+				time = moveArm(time, state);
+				time += (1 + random(3))*second;
+			}
+
+			planGlitches(start, time, position);
+		}
+
+		uint64_t moveArm(uint64_t time, int state)
+		{
+			// The sensor the arm is leaving chatters as the magnet pulls away, and the one it comes to chatters before it
+			// settles.
+			chatter(time, TIMELINE::MOVEARM, TIMELINE::ARM, _plannedPosition);
+			_plannedPosition = state;
+			time += 150000;
+			return chatter(time, TIMELINE::ARM, TIMELINE::MOVEARM, state);
+		}
+
+		void pushButton(uint64_t time, TIMELINE::BUTTON button)
+		{
+			time = chatter(time, TIMELINE::PRESS, TIMELINE::RELEASE, button);
+			chatter(time + 100000, TIMELINE::RELEASE, TIMELINE::PRESS, button);
+		}
+
+		// Adds a contact that bounces between "away" and "settle" for the bounce time before settling.  Each bounce is
+		// shorter than a millisecond.  Returns the time it settles.
+		uint64_t chatter(uint64_t time, TIMELINE::ACTION settle, TIMELINE::ACTION away, int value)
+		{
+			for (uint64_t end = time + _bounce; time < end; )
+			{
+				_cycle.add(time, settle, value);
+				time += 100 + random(800);
+				_cycle.add(time, away, value);
+				time += 100 + random(800);
+			}
+			_cycle.add(time, settle, value);
+			return time;
+		}
+
+		// Adds noise that makes the sensors read as a random position for up to half a millisecond.  The glitches fall
+		// between the operator's actions, and the sensors go back to where the arm is afterwards.  "Position" is where the
+		// arm is at the start.
+		void planGlitches(uint64_t time, uint64_t end, int position)
+		{
+			if (_glitches == 0)
+			{
+				return;
+			}
+
+			size_t next = 0;
+
+			while (true)
+			{
+				time += 1000*(uint64_t)random((int)(2*3600000/_glitches) + 1);
+				if (time >= end)
+				{
+					return;
+				}
+
+				// Find where the arm is (-1 while it is moving).
+				for (; next < _cycle.size() && _cycle[next].time <= time; next++)
+				{
+					position = _cycle[next].action == TIMELINE::ARM ? _cycle[next].value : (_cycle[next].action == TIMELINE::MOVEARM ? -1 : position);
+				}
+
+				int			sensor	= random(GENERATOR::NUMBEROFSTATES);
+				uint64_t	clear	= time + 50 + random(450);
+				if (next < _cycle.size() && _cycle[next].time <= clear)
+				{
+					continue;
+				}
+
+				_glitchEvents.add(time, TIMELINE::ARM, sensor);
+				if (position < 0)
+				{
+					_glitchEvents.add(clear, TIMELINE::MOVEARM);
+				}
+				else
+				{
+					_glitchEvents.add(clear, TIMELINE::ARM, position);
+				}
+			}
+		}
+
+		// Xorshift, so runs are repeatable on every platform.
+		int random(int range)
+		{
+			_random ^= _random << 13;
+			_random ^= _random >> 17;
+			_random ^= _random << 5;
+			return (int)(_random % (uint32_t)range);
+		}
+
+	private:
+		Configuration&									_configuration;
+		uint32_t										_random;
+		unsigned long									_bounce;
+		unsigned long									_glitches;
+		Timeline										_cycle;
+		Timeline										_glitchEvents;
+		size_t											_nextEvent;
+		size_t											_nextGlitch;
+		int												_position;
+		int												_plannedPosition;
+};
+
+// Statistics of the state machine transitions, gathered with the generator's transition hook.
+struct TransitionStatistics
+{
+	unsigned long		count;
+	unsigned long		maximumTime;
+};
+
+static TransitionStatistics transitionStatistics[2];
+
+// Measures how far the light cues synchronized to a sound land from the start of the sound.  The overload sequence
+// changes the white light as the overload sound starts, so the first change of the white light after the sound is
+// asked for is compared with when the audio board started playing it.  A cue cut short by the arm moving is not counted.
+// Without its own trigger line, the overload sound shares the state change one, so a trigger pulled in the same pass as
+// a state change is taken to be the state change sound.
+class CueMeter
+{
+	public:
+		CueMeter() :
+			_waiting(false),
+			_stateChanged(false),
+			_soundStart(0),
+			_lastRequest(0),
+			_lastWhiteChange(0),
+			_cues(0),
+			_totalError(0),
+			_worstError(0)
+		{
+		}
+
+		void update(SimulatedHardware& hardware)
+		{
+			#if useAudioSerial
+				SimulatedAudioBoard& audioBoard	= hardware.getAudioBoard();
+				uint64_t request				= audioBoard.getLastPlayTime();
+				if (request != _lastRequest && audioBoard.getLastFile() == "OVERLOADOGG")
+				{
+					_waiting	= true;
+					_soundStart	= audioBoard.getLastStartTime();
+				}
+			#else
+				uint8_t		trigger	= Configuration::outputs[Configuration::overloadAudioTrigger];
+				uint64_t	request	= hardware.getShiftRegisterChangeTime(trigger);
+				if (request != _lastRequest && !(hardware.getShiftRegisterOutput() >> trigger & 1) && !_stateChanged)
+				{
+					_waiting	= true;
+					_soundStart	= request + simulatedAudioReplyTime;
+				}
+			#endif
+			_lastRequest	= request;
+			_stateChanged	= false;
+
+			uint64_t whiteChange = hardware.getShiftRegisterChangeTime(Configuration::outputs[LIGHT::WHITE]);
+			if (whiteChange != _lastWhiteChange && _waiting)
+			{
+				int64_t error	= (int64_t)(whiteChange - _soundStart);
+				_totalError	   += error < 0 ? -error : error;
+				if ((error < 0 ? -error : error) > (_worstError < 0 ? -_worstError : _worstError))
+				{
+					_worstError = error;
+				}
+				_cues++;
+				_waiting = false;
+			}
+			_lastWhiteChange = whiteChange;
+		}
+
+		void cancel()
+		{
+			_waiting		= false;
+			_stateChanged	= true;
+		}
+
+		void print()
+		{
+			printf("Light cue alignment:     %lu cues, %.3f ms average error, %+.3f ms worst (positive is light after sound)\n", _cues, _cues ? _totalError/1000.0/_cues : 0.0, _worstError/1000.0);
+		}
+
+	private:
+		bool											_waiting;
+		bool											_stateChanged;
+		uint64_t										_soundStart;
+		uint64_t										_lastRequest;
+		uint64_t										_lastWhiteChange;
+
+		unsigned long									_cues;
+		int64_t											_totalError;
+		int64_t											_worstError;
+};
+
+static CueMeter cueMeter;
+
+static void recordTransition(STATEMACHINE::MACHINE machine, uint8_t, uint8_t, unsigned long time)
+{
+	if (machine == STATEMACHINE::GENERATORSTATE)
+	{
+		cueMeter.cancel();
+	}
+
+	transitionStatistics[machine].count++;
+	if (time > transitionStatistics[machine].maximumTime)
+	{
+		transitionStatistics[machine].maximumTime = time;
+	}
+}
+
+// Host time (nanoseconds) of one overload ramp frame.  The target is changed every few frames so the ramp never
+// settles and every frame does the full interpolation.  A frame does the same work every time, so this bounds it.
+static double timeOverloadRamp(const Configuration& configuration, OVERLOAD::CURVE curve)
+{
+	const unsigned long	frames			= 10000000;
+	unsigned int		criticalDelay	= configuration.blueLightStandardDelay - (GENERATOR::NUMBEROFSPECIALMODES-1)*configuration.blueLightOverloadIncrement;
+
+	OverloadRamp ramp;
+	ramp.begin(curve, configuration.overloadRampSteps, criticalDelay);
+	ramp.reset(configuration.blueLightStandardDelay);
+
+	volatile unsigned int	sink	= 0;
+	clock_t					start	= clock();
+
+	for (unsigned long i = 0; i < frames; i++)
+	{
+		if (i % 4 == 0)
+		{
+			ramp.setTarget(i & 4 ? criticalDelay : configuration.blueLightStandardDelay);
+		}
+		sink = sink + ramp.update();
+	}
+
+	return 1.0e9 * (double)(clock() - start) / CLOCKS_PER_SEC / frames;
+}
+
+// Host time (nanoseconds) to change the blue lights to a new bar graph, a pattern at a time.  "bitByBit" sets the five
+// outputs one after the other (the way it used to be done), otherwise the frame is written with one masked write.
+static double timeBlueLightPattern(const Configuration& configuration, bool bitByBit)
+{
+	const unsigned long	patterns	= 10000000;
+
+	HAL::ShiftRegister<Configuration::numberOfShiftRegisters>	shiftRegister(configuration.shiftRegisterDataPin, configuration.shiftRegisterClockPin, configuration.shiftRegisterLatchPin);
+	OutputFrame<Configuration>									frame(&shiftRegister);
+
+	volatile uint8_t	numberOfLights	= 0;
+	clock_t				start			= clock();
+
+	for (unsigned long i = 0; i < patterns; i++)
+	{
+		numberOfLights = i % (LIGHT::NUMBEROFBLUELIGHTS + 1);
+
+		if (bitByBit)
+		{
+			for (int light = LIGHT::BLUE1; light <= LIGHT::BLUE5; light++)
+			{
+				frame.set(light, light < LIGHT::BLUE1 + numberOfLights ? LIGHT::ON : LIGHT::OFF);
+			}
+		}
+		else
+		{
+			frame.setMasked(configuration.blueLightMask, HAL::readProgramMemory(&barGraphFrames[numberOfLights]) << configuration.firstBlueLightOutput);
+		}
+	}
+
+	return 1.0e9 * (double)(clock() - start) / CLOCKS_PER_SEC / patterns;
+}
+
+// Host time (nanoseconds) for the scheduler to hand out a due timer and set it again, with every timer of the pool
+// running.  The deadlines are all in the past and spread out, so each timer moves the whole depth of the heap.
+static double timeScheduler()
+{
+	const unsigned long	dispatches	= 10000000;
+	unsigned long		now			= HAL::millis();
+
+	Scheduler scheduler;
+	for (uint8_t timer = 0; timer < nSchedulerTimers; timer++)
+	{
+		scheduler.schedule(timer, now - 1000 + timer);
+	}
+
+	uint8_t	timer;
+	clock_t	start = clock();
+
+	for (unsigned long i = 0; i < dispatches; i++)
+	{
+		scheduler.getNextDue(timer);
+		scheduler.schedule(timer, now - 1000 + (i*7919) % 1000);
+	}
+
+	return 1.0e9 * (double)(clock() - start) / CLOCKS_PER_SEC / dispatches;
+}
+
+int main(int argc, char* argv[])
+{
+	double			hours		= 1;
+	unsigned long	step		= 100;
+	unsigned long	seed		= 1;
+	const char*		recordName	= nullptr;
+	bool			echoSerial	= false;
+	int				noise		= 0;
+	double			capacity	= 2000;
+	double			load		= 15;
+	unsigned long	audioReply	= simulatedAudioReplyTime/1000;
+	unsigned long	bounce		= 0;
+	unsigned long	glitches	= 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--hours") == 0 && i+1 < argc)
+		{
+			hours = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--step") == 0 && i+1 < argc)
+		{
+			step = strtoul(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--seed") == 0 && i+1 < argc)
+		{
+			seed = strtoul(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--record") == 0 && i+1 < argc)
+		{
+			recordName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--serial") == 0)
+		{
+			echoSerial = true;
+		}
+		else if (strcmp(argv[i], "--noise") == 0 && i+1 < argc)
+		{
+			noise = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--battery") == 0 && i+1 < argc)
+		{
+			capacity = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--load") == 0 && i+1 < argc)
+		{
+			load = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--audio-reply") == 0 && i+1 < argc)
+		{
+			audioReply = strtoul(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--bounce") == 0 && i+1 < argc)
+		{
+			bounce = strtoul(argv[++i], nullptr, 10);
+		}
+		else if (strcmp(argv[i], "--glitches") == 0 && i+1 < argc)
+		{
+			glitches = strtoul(argv[++i], nullptr, 10);
+		}
+		else
+		{
+			fprintf(stderr, "Usage: %s [--hours hours] [--step microseconds] [--seed seed] [--record file] [--serial] [--noise counts] [--battery milliamp-hours] [--load milliamps] [--audio-reply milliseconds] [--bounce microseconds] [--glitches count]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	FILE* recordFile = nullptr;
+	if (recordName != nullptr)
+	{
+		recordFile = fopen(recordName, "w");
+		if (recordFile == nullptr)
+		{
+			fprintf(stderr, "Unable to create \"%s\".\n", recordName);
+			return 1;
+		}
+		fprintf(recordFile, "# Recorded by NaquadahSimulator, seed %lu.\n0 arm OFF\n", seed);
+	}
+
+	SimulatedHardware& hardware = SimulatedHardware::instance();
+	hardware.getSerial().setEcho(echoSerial);
+	hardware.setAnalogNoise(noise);
+	hardware.getAudioBoard().setReplyTime(audioReply*1000);
+
+	// The arm starts in the off position and the battery is full.
+	Configuration configuration;
+	hardware.driveInput(configuration.stateInputPins[GENERATOR::OFF], LOW);
+	hardware.setAnalogInput(configuration.batteryMeterSensePin, configuration.batteryMaxReading);
+
+	if (debugLevel > DEBUG::OFF)
+	{
+		Log::begin(9600);
+	}
+
+	NaquadahGenerator<Configuration> generator;
+	generator.setTransitionHook(recordTransition);
+	generator.begin();
+
+	Operator		simulatedOperator(configuration, seed, bounce, glitches);
+	uint64_t		endTime		= (uint64_t)(hours*3600.0*1000000.0);
+	uint64_t		startTime	= hardware.getTime();
+	unsigned long	loops		= 0;
+	unsigned long	armMoves	= 0;
+	clock_t			wallStart	= clock();
+
+	hardware.resetCounters();
+	Log::resetStatistics();
+
+	while (hardware.getTime() < endTime)
+	{
+		armMoves += simulatedOperator.update(hardware.getTime(), recordFile);
+		generator.update();
+		cueMeter.update(hardware);
+		hardware.advance(step);
+		loops++;
+	}
+
+	if (recordFile != nullptr)
+	{
+		TimelineEvent end = {hardware.getTime(), TIMELINE::END, 0};
+		Timeline::write(recordFile, end);
+		fclose(recordFile);
+	}
+
+	double wallSeconds		= (double)(clock() - wallStart) / CLOCKS_PER_SEC;
+	double simulatedSeconds	= (double)(hardware.getTime() - startTime) / 1000000.0;
+	const SimulatedHardware::Counters& counters = hardware.getCounters();
+
+	printf("Simulated time:          %.1f hours\n", simulatedSeconds/3600.0);
+	printf("Wall clock time:         %.2f seconds (%.0fx real time)\n", wallSeconds, wallSeconds > 0 ? simulatedSeconds/wallSeconds : 0.0);
+	printf("Loops:                   %lu (%.1f microseconds average)\n", loops, loops ? 1000000.0*simulatedSeconds/loops : 0.0);
+	printf("Arm positions reached:   %lu\n", armMoves);
+	printf("State changes:           %lu (%lu microseconds longest)\n", transitionStatistics[STATEMACHINE::GENERATORSTATE].count, transitionStatistics[STATEMACHINE::GENERATORSTATE].maximumTime);
+	printf("Special mode changes:    %lu (%lu microseconds longest)\n", transitionStatistics[STATEMACHINE::SPECIALMODE].count, transitionStatistics[STATEMACHINE::SPECIALMODE].maximumTime);
+	printf("Digital reads:           %lu\n", counters.digitalReads);
+	printf("Digital writes:          %lu\n", counters.digitalWrites);
+	printf("Analog reads:            %lu blocking (%.3f seconds), %lu converted in the background\n", counters.analogReads, counters.analogReads*simulatedAnalogReadTime/1000000.0, counters.analogConversions);
+	printf("Shift register latches:  %lu (%lu bits, %.3f seconds shifting)\n", counters.shiftRegisterLatches, counters.shiftRegisterBits, counters.shiftRegisterMicroseconds/1000000.0);
+	printf("Timer interrupts:        %lu (%.3f seconds, %.1f%% of the processor)\n", counters.interrupts, counters.interruptMicroseconds/1000000.0, simulatedSeconds > 0 ? 100.0*counters.interruptMicroseconds/1000000.0/simulatedSeconds : 0.0);
+	// The processor draws the idle current while asleep and the active current the rest of the time.
+	double asleep		= simulatedSeconds > 0 ? counters.sleepMicroseconds/1000000.0/simulatedSeconds : 0.0;
+	double current		= load + simulatedIdleCurrent*asleep + simulatedActiveCurrent*(1.0 - asleep);
+	double awakeCurrent	= load + simulatedActiveCurrent;
+	printf("Processor sleep:         %lu sleeps, %.1f%% awake (%.2f milliamps average, %.2f milliamps awake)\n", counters.sleeps, 100.0*(1.0 - asleep), current - load, simulatedActiveCurrent);
+	printf("Battery life:            %.1f hours at %.2f milliamps (%.1f hours without sleep at %.2f milliamps)\n", capacity/current, current, capacity/awakeCurrent, awakeCurrent);
+	SimulatedAudioBoard& audioBoard = hardware.getAudioBoard();
+	printf("Audio board:             %lu commands, %lu files started, %lu replaced by another, %lu played to the end\n", audioBoard.getCommands(), audioBoard.getFilesStarted(), audioBoard.getFilesReplaced(), audioBoard.getFilesFinished());
+	cueMeter.print();
+	printf("Debug serial bytes:      %lu (%.1f seconds blocked)\n", hardware.getSerial().getBytesWritten(), hardware.getSerial().getBlockedMicroseconds()/1000000.0);
+	printf("Debug log bytes:         %lu queued, %lu dropped (%u of %u buffer bytes used at most)\n", Log::getBytesQueued(), Log::getBytesDropped(), (unsigned int)Log::getMaximumUsed(), (unsigned int)nLogBufferBytes);
+
+	const char*	curveNames[]	= {"LINEAR", "EASEIN", "EASEOUT", "SMOOTHSTEP"};
+	double		worstFrame		= 0;
+	int			worstCurve		= 0;
+	for (int curve = OVERLOAD::LINEAR; curve <= OVERLOAD::SMOOTHSTEP; curve++)
+	{
+		double frame = timeOverloadRamp(configuration, (OVERLOAD::CURVE)curve);
+		if (frame > worstFrame)
+		{
+			worstFrame = frame;
+			worstCurve = curve;
+		}
+	}
+	printf("Overload ramp frame:     %.1f nanoseconds on this host at most (%s)\n", worstFrame, curveNames[worstCurve]);
+	printf("Blue light pattern:      %.1f nanoseconds as a masked frame write, %.1f nanoseconds bit by bit on this host\n", timeBlueLightPattern(configuration, false), timeBlueLightPattern(configuration, true));
+	printf("Scheduler dispatch:      %.1f nanoseconds on this host with all %d timers running\n", timeScheduler(), nSchedulerTimers);
+
+	return 0;
+}
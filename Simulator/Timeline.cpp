@@ -0,0 +1,213 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#include "Timeline.h"
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+namespace
+{
+	const char* stateNames[GENERATOR::NUMBEROFSTATES]	= {"OFF", "PRIMED0", "PRIMED1", "ON"};
+	const char* buttonNames[]							= {"mode", "battery"};
+
+	int findName(const char* names[], int count, const char name[])
+	{
+		for (int i = 0; i < count; i++)
+		{
+			if (strcmp(names[i], name) == 0)
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+}
+
+bool Timeline::load(const char fileName[])
+{
+	FILE* file = fopen(fileName, "r");
+	if (file == nullptr)
+	{
+		fprintf(stderr, "Unable to open timeline \"%s\".\n", fileName);
+		return false;
+	}
+
+	char	line[256];
+	int		lineNumber	= 0;
+	bool	result		= true;
+
+	while (fgets(line, sizeof(line), file) != nullptr)
+	{
+		lineNumber++;
+
+		char* comment = strchr(line, '#');
+		if (comment != nullptr)
+		{
+			*comment = '\0';
+		}
+
+		char	action[32]		= "";
+		char	argument[32]	= "";
+		double	time;
+
+		int fields = sscanf(line, "%lf %31s %31s", &time, action, argument);
+		if (fields <= 0)
+		{
+			// Blank line.
+			continue;
+		}
+
+		uint64_t	microseconds	= (uint64_t)(time*1000.0);
+		int			value			= -1;
+
+		if (fields >= 2 && strcmp(action, "arm") == 0)
+		{
+			value = findName(stateNames, GENERATOR::NUMBEROFSTATES, argument);
+			if (value >= 0)
+			{
+				add(microseconds, TIMELINE::ARM, value);
+			}
+		}
+		else if (fields >= 2 && strcmp(action, "movearm") == 0)
+		{
+			value = 0;
+			add(microseconds, TIMELINE::MOVEARM);
+		}
+		else if (fields >= 2 && (strcmp(action, "press") == 0 || strcmp(action, "release") == 0))
+		{
+			value = findName(buttonNames, 2, argument);
+			if (value >= 0)
+			{
+				add(microseconds, action[0] == 'p' ? TIMELINE::PRESS : TIMELINE::RELEASE, value);
+			}
+		}
+		else if (fields == 3 && strcmp(action, "battery") == 0)
+		{
+			value = atoi(argument);
+			add(microseconds, TIMELINE::BATTERY, value);
+		}
+		else if (fields >= 2 && strcmp(action, "end") == 0)
+		{
+			value = 0;
+			add(microseconds, TIMELINE::END);
+		}
+
+		if (value < 0)
+		{
+			fprintf(stderr, "%s:%d: unable to read event.\n", fileName, lineNumber);
+			result = false;
+		}
+	}
+
+	fclose(file);
+	return result;
+}
+
+void Timeline::add(uint64_t time, TIMELINE::ACTION action, int value)
+{
+	TimelineEvent event = {time, action, value};
+
+	// Keep the events in order.  Events at the same time stay in the order they were added.
+	std::vector<TimelineEvent>::iterator position = std::upper_bound(_events.begin(), _events.end(), event,
+		[](const TimelineEvent& a, const TimelineEvent& b) { return a.time < b.time; });
+	_events.insert(position, event);
+}
+
+size_t Timeline::size() const
+{
+	return _events.size();
+}
+
+const TimelineEvent& Timeline::operator[](size_t index) const
+{
+	return _events[index];
+}
+
+void Timeline::clear()
+{
+	_events.clear();
+}
+
+void Timeline::apply(const TimelineEvent& event, const Configuration& configuration)
+{
+	SimulatedHardware&	hardware		= SimulatedHardware::instance();
+	int					buttonPin		= event.value == TIMELINE::BATTERYBUTTON ? configuration.batteryMeterActivationPin : configuration.modeButtonPin;
+
+	switch (event.action)
+	{
+		case TIMELINE::ARM:
+		case TIMELINE::MOVEARM:
+		{
+			for (int i = 0; i < GENERATOR::NUMBEROFSTATES; i++)
+			{
+				hardware.releaseInput(configuration.stateInputPins[i]);
+			}
+
+			// The sensors pull low when they see the magnet.
+			if (event.action == TIMELINE::ARM)
+			{
+				hardware.driveInput(configuration.stateInputPins[event.value], LOW);
+			}
+			break;
+		}
+
+		case TIMELINE::PRESS:
+		{
+			hardware.driveInput(buttonPin, LOW);
+			break;
+		}
+
+		case TIMELINE::RELEASE:
+		{
+			hardware.releaseInput(buttonPin);
+			break;
+		}
+
+		case TIMELINE::BATTERY:
+		{
+			hardware.setAnalogInput(configuration.batteryMeterSensePin, event.value);
+			break;
+		}
+
+		case TIMELINE::END:
+		{
+			break;
+		}
+	}
+}
+
+void Timeline::write(FILE* file, const TimelineEvent& event)
+{
+	char buffer[64];
+	fprintf(file, "%.3f %s\n", event.time/1000.0, describe(event, buffer, sizeof(buffer)));
+}
+
+const char* Timeline::describe(const TimelineEvent& event, char buffer[], size_t size)
+{
+	switch (event.action)
+	{
+		case TIMELINE::ARM:			snprintf(buffer, size, "arm %s", stateNames[event.value]);			break;
+		case TIMELINE::MOVEARM:		snprintf(buffer, size, "movearm");									break;
+		case TIMELINE::PRESS:		snprintf(buffer, size, "press %s", buttonNames[event.value]);		break;
+		case TIMELINE::RELEASE:		snprintf(buffer, size, "release %s", buttonNames[event.value]);		break;
+		case TIMELINE::BATTERY:		snprintf(buffer, size, "battery %d", event.value);					break;
+		case TIMELINE::END:			snprintf(buffer, size, "end");										break;
+	}
+	return buffer;
+}
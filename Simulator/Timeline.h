@@ -0,0 +1,102 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <stdio.h>
+#include <vector>
+#include "NaquadahGenerator.h"
+
+namespace TIMELINE
+{
+	enum ACTION
+	{
+		// Put the arm at a position (value is a GENERATOR::STATE).
+		ARM,
+
+		// Take the arm away from its position.  No sensor sees the magnet while it is moving.
+		MOVEARM,
+
+		// Push or let go of a button (value is a TIMELINE::BUTTON).
+		PRESS,
+		RELEASE,
+
+		// Change the reading of the battery sensing pin (value is the reading).
+		BATTERY,
+
+		// Nothing happens, the timeline just runs until this time.
+		END
+	};
+
+	enum BUTTON
+	{
+		MODEBUTTON,
+		BATTERYBUTTON
+	};
+}
+
+// Something that happens to the generator from the outside world at a set time (microseconds of virtual time).
+struct TimelineEvent
+{
+	uint64_t											time;
+	TIMELINE::ACTION									action;
+	int													value;
+};
+
+// A list of events that happen to the generator, in time order.  Timelines are scripted or recorded as text, one event
+// per line:
+//
+//		<time in milliseconds> arm <OFF | PRIMED0 | PRIMED1 | ON>
+//		<time in milliseconds> movearm
+//		<time in milliseconds> press <mode | battery>
+//		<time in milliseconds> release <mode | battery>
+//		<time in milliseconds> battery <reading>
+//		<time in milliseconds> end
+//
+// Everything after a "#" is a comment.
+class Timeline
+{
+	// Public interface.
+	public:
+		// Reads a text timeline.  Prints the problem and returns false if the file can't be read.
+		bool load(const char fileName[]);
+
+		// Adds an event.  Events do not need to be added in order.
+		void add(uint64_t time, TIMELINE::ACTION action, int value = 0);
+
+		size_t size() const;
+		const TimelineEvent& operator[](size_t index) const;
+
+		// Removes all the events.
+		void clear();
+
+		// Makes the event happen on the simulated hardware.
+		static void apply(const TimelineEvent& event, const Configuration& configuration);
+
+		// Writes an event as a line of a text timeline.
+		static void write(FILE* file, const TimelineEvent& event);
+
+		// Short description of the event for reports.
+		static const char* describe(const TimelineEvent& event, char buffer[], size_t size);
+
+	private:
+		std::vector<TimelineEvent>						_events;
+};
+
+#endif
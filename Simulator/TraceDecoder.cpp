@@ -0,0 +1,361 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+/*
+	Decodes the trace the generator sends out on its debug serial port (see Trace.h) and rebuilds the timeline of events,
+	followed by latency histograms.  The input is a capture of the serial port, for example from the serial monitor or
+	from "NaquadahReplay --trace".  Anything that isn't part of a trace is skipped, and every trace in the input is
+	decoded.
+
+	Histograms:
+		Sensor to state change		Time from a state sensor change being sampled to the generator changing state.
+		Blue light step				Time between steps of the scrolling blue light.
+		Audio trigger pulse			Time an audio trigger line was held active.
+
+	Usage:
+		NaquadahTrace [file]
+
+		Reads standard input if no file is given.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "Trace.h"
+
+namespace
+{
+	const char* eventNames[TRACE::NUMBEROFEVENTS]		= {"gap", "input edge", "state change", "special mode", "blue light", "audio trigger", "overload"};
+	const char* phaseNames[]							= {"STEADY", "RAMPING", "CRITICAL"};
+	const char* stateNames[GENERATOR::NUMBEROFSTATES]	= {"OFF", "PRIMED0", "PRIMED1", "ON"};
+
+	struct DecodedEvent
+	{
+		uint64_t										time;
+		TRACE::EVENT									event;
+		uint8_t											payload;
+	};
+
+	// Times are grouped into buckets that double in size: 0-16, 16-32, 32-64 microseconds, and so on.
+	class Histogram
+	{
+		public:
+			Histogram(const char name[]) :
+				_name(name),
+				_buckets(32, 0),
+				_count(0),
+				_total(0),
+				_minimum(0),
+				_maximum(0)
+			{
+			}
+
+			void add(uint64_t microseconds)
+			{
+				int bucket = 0;
+				while (bucket < 31 && microseconds >= (16ULL << bucket))
+				{
+					bucket++;
+				}
+				_buckets[bucket]++;
+
+				_minimum	= _count == 0 || microseconds < _minimum ? microseconds : _minimum;
+				_maximum	= microseconds > _maximum ? microseconds : _maximum;
+				_total	   += microseconds;
+				_count++;
+			}
+
+			void print()
+			{
+				printf("\n%s: ", _name);
+				if (_count == 0)
+				{
+					printf("none\n");
+					return;
+				}
+
+				printf("%lu (mean %.3f ms, minimum %.3f ms, maximum %.3f ms)\n", _count, _total/1000.0/_count, _minimum/1000.0, _maximum/1000.0);
+
+				int first = 0;
+				int last = 31;
+				while (_buckets[first] == 0)
+				{
+					first++;
+				}
+				while (_buckets[last] == 0)
+				{
+					last--;
+				}
+
+				unsigned long largest = 0;
+				for (int i = first; i <= last; i++)
+				{
+					largest = _buckets[i] > largest ? _buckets[i] : largest;
+				}
+
+				for (int i = first; i <= last; i++)
+				{
+					unsigned long low	= i == 0 ? 0 : 16UL << (i-1);
+					unsigned long high	= 16UL << i;
+					int width			= (int)((40*_buckets[i] + largest - 1) / largest);
+
+					printf("  %10.3f - %10.3f ms %6lu  %.*s\n", low/1000.0, high/1000.0, _buckets[i], width, "########################################");
+				}
+			}
+
+		private:
+			const char*									_name;
+			std::vector<unsigned long>					_buckets;
+			unsigned long								_count;
+			uint64_t									_total;
+			uint64_t									_minimum;
+			uint64_t									_maximum;
+	};
+
+	const char* describePayload(const DecodedEvent& event, char buffer[], size_t size)
+	{
+		switch (event.event)
+		{
+			case TRACE::INPUTEDGE:
+			{
+				int length = snprintf(buffer, size, "sensors");
+				for (int i = 0; i < GENERATOR::NUMBEROFSTATES; i++)
+				{
+					if (event.payload & (1 << i))
+					{
+						length += snprintf(buffer + length, size - length, " %s", stateNames[i]);
+					}
+				}
+				if (event.payload == 0)
+				{
+					snprintf(buffer + length, size - length, " none");
+				}
+				break;
+			}
+
+			case TRACE::STATECHANGE:
+			{
+				snprintf(buffer, size, "%s", event.payload < GENERATOR::NUMBEROFSTATES ? stateNames[event.payload] : "?");
+				break;
+			}
+
+			case TRACE::SPECIALMODE:
+			{
+				snprintf(buffer, size, "mode %d", event.payload);
+				break;
+			}
+
+			case TRACE::BLUELIGHT:
+			{
+				snprintf(buffer, size, "blue %d", event.payload - LIGHT::BLUE1 + 1);
+				break;
+			}
+
+			case TRACE::AUDIOTRIGGER:
+			{
+				snprintf(buffer, size, "output %d %s", event.payload & 0x7F, event.payload & 0x80 ? "HIGH" : "LOW");
+				break;
+			}
+
+			case TRACE::OVERLOADPHASE:
+			{
+				snprintf(buffer, size, "%s", event.payload <= OVERLOAD::CRITICAL ? phaseNames[event.payload] : "?");
+				break;
+			}
+
+			default:
+			{
+				buffer[0] = '\0';
+				break;
+			}
+		}
+		return buffer;
+	}
+
+	void decode(const std::vector<DecodedEvent>& events, unsigned long overwritten, int traceNumber)
+	{
+		printf("Trace %d: %lu events", traceNumber, (unsigned long)events.size());
+		if (overwritten > 0)
+		{
+			printf(" (%lu older events were overwritten)", overwritten);
+		}
+		printf("\n\n%12s  %-15s %s\n", "Time (ms)", "Event", "Payload");
+
+		Histogram sensorLatency("Sensor to state change");
+		Histogram blueLightStep("Blue light step");
+		Histogram audioPulse("Audio trigger pulse");
+
+		bool		edgePending			= false;
+		uint64_t	edgeTime			= 0;
+		bool		bluePending			= false;
+		uint64_t	blueTime			= 0;
+		uint64_t	triggerTime[128]	= {0};
+		bool		triggerActive[128]	= {false};
+
+		for (size_t i = 0; i < events.size(); i++)
+		{
+			const DecodedEvent& event = events[i];
+			char payload[64];
+
+			if (event.event != TRACE::GAP)
+			{
+				printf("%12.3f  %-15s %s\n", event.time/1000.0, event.event < TRACE::NUMBEROFEVENTS ? eventNames[event.event] : "?", describePayload(event, payload, sizeof(payload)));
+			}
+
+			switch (event.event)
+			{
+				case TRACE::INPUTEDGE:
+				{
+					edgePending	= true;
+					edgeTime	= event.time;
+					break;
+				}
+
+				case TRACE::STATECHANGE:
+				{
+					if (edgePending)
+					{
+						sensorLatency.add(event.time - edgeTime);
+						edgePending = false;
+					}
+
+					// The blue light starts over in a new state.
+					bluePending = false;
+					break;
+				}
+
+				case TRACE::BLUELIGHT:
+				{
+					if (bluePending)
+					{
+						blueLightStep.add(event.time - blueTime);
+					}
+					bluePending	= true;
+					blueTime	= event.time;
+					break;
+				}
+
+				case TRACE::AUDIOTRIGGER:
+				{
+					// The triggers are active low.
+					uint8_t output = event.payload & 0x7F;
+					if (!(event.payload & 0x80))
+					{
+						triggerActive[output]	= true;
+						triggerTime[output]		= event.time;
+					}
+					else if (triggerActive[output])
+					{
+						audioPulse.add(event.time - triggerTime[output]);
+						triggerActive[output] = false;
+					}
+					break;
+				}
+
+				default:
+				{
+					break;
+				}
+			}
+		}
+
+		sensorLatency.print();
+		blueLightStep.print();
+		audioPulse.print();
+		printf("\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	FILE* file = stdin;
+
+	if (argc > 2 || (argc == 2 && argv[1][0] == '-'))
+	{
+		fprintf(stderr, "Usage: %s [file]\n", argv[0]);
+		return 1;
+	}
+
+	if (argc == 2)
+	{
+		file = fopen(argv[1], "r");
+		if (file == nullptr)
+		{
+			fprintf(stderr, "Unable to open \"%s\".\n", argv[1]);
+			return 1;
+		}
+	}
+
+	std::vector<DecodedEvent>	events;
+	bool						inTrace		= false;
+	uint64_t					time		= 0;
+	unsigned long				overwritten	= 0;
+	int							traces		= 0;
+	char						line[256];
+
+	while (fgets(line, sizeof(line), file) != nullptr)
+	{
+		// The trace may follow other output on the same line if a message was cut off.
+		const char* text = strstr(line, "TRACE ");
+		if (text == nullptr)
+		{
+			continue;
+		}
+
+		unsigned long	start;
+		unsigned int	count;
+		unsigned int	event;
+		unsigned int	payload;
+		unsigned int	delta;
+
+		if (sscanf(text, "TRACE BEGIN %lu %u %lu", &start, &count, &overwritten) == 3)
+		{
+			inTrace		= true;
+			time		= start;
+			events.clear();
+		}
+		else if (strncmp(text, "TRACE END", 9) == 0)
+		{
+			if (inTrace)
+			{
+				decode(events, overwritten, ++traces);
+			}
+			inTrace = false;
+		}
+		else if (inTrace && sscanf(text, "TRACE %2x%2x%4x", &event, &payload, &delta) == 3)
+		{
+			// The deltas are in ticks, the gaps in units of 65536 ticks.
+			time += (event == TRACE::GAP ? (uint64_t)delta << 16 : delta) * traceTickTime;
+
+			DecodedEvent decoded = {time, (TRACE::EVENT)event, (uint8_t)payload};
+			events.push_back(decoded);
+		}
+	}
+
+	if (file != stdin)
+	{
+		fclose(file);
+	}
+
+	if (traces == 0)
+	{
+		fprintf(stderr, "No trace found.\n");
+		return 1;
+	}
+
+	return 0;
+}
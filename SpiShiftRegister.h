@@ -0,0 +1,116 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+
+#ifndef SPISHIFTREGISTER_H
+#define SPISHIFTREGISTER_H
+
+#include <Arduino.h>
+#include <SPI.h>
+
+// The 74HC595 is good to well over the fastest SPI clock of a 16 MHz AVR.
+#define spiShiftRegisterClock			8000000
+
+// Drives a chain of 74HC595 shift registers with the hardware SPI peripheral instead of shifting the bits out in
+// software.  The interface matches the parts of the ShiftRegister74HC595 library used by the generator so the two can be
+// swapped (see shiftRegisterBackend in the configuration).  The data and clock lines are fixed to the SPI pins, so those
+// arguments are only there to match the library.
+template<uint8_t numberOfShiftRegisters> class SpiShiftRegister
+{
+	// Constructors.
+	public:
+		SpiShiftRegister(int serialDataPin, int clockPin, int latchPin) :
+			_latchPin(latchPin),
+			_started(false)
+		{
+			(void)serialDataPin;
+			(void)clockPin;
+
+			for (int i = 0; i < numberOfShiftRegisters; i++)
+			{
+				_digitalValues[i] = 0;
+			}
+		}
+
+	// Public interface.
+	public:
+		void setAll(const uint8_t* digitalValues)
+		{
+			for (int i = 0; i < numberOfShiftRegisters; i++)
+			{
+				_digitalValues[i] = digitalValues[i];
+			}
+			updateRegisters();
+		}
+
+		uint8_t* getAll()
+		{
+			return _digitalValues;
+		}
+
+		void set(const uint8_t pin, const uint8_t value)
+		{
+			setNoUpdate(pin, value);
+			updateRegisters();
+		}
+
+		void setNoUpdate(const uint8_t pin, const uint8_t value)
+		{
+			if (value == HIGH)
+			{
+				_digitalValues[pin / 8] |= 1 << (pin % 8);
+			}
+			else
+			{
+				_digitalValues[pin / 8] &= ~(1 << (pin % 8));
+			}
+		}
+
+		uint8_t get(const uint8_t pin)
+		{
+			return (_digitalValues[pin / 8] >> (pin % 8)) & 1;
+		}
+
+		void updateRegisters()
+		{
+			// The SPI peripheral is started on first use so that nothing is touched before the Arduino core has been
+			// initialized.
+			if (!_started)
+			{
+				pinMode(_latchPin, OUTPUT);
+				SPI.begin();
+				_started = true;
+			}
+
+			// Same order as the library: the last register in the chain goes first, most significant bit first.
+			SPI.beginTransaction(SPISettings(spiShiftRegisterClock, MSBFIRST, SPI_MODE0));
+			digitalWrite(_latchPin, LOW);
+			for (int i = numberOfShiftRegisters - 1; i >= 0; i--)
+			{
+				SPI.transfer(_digitalValues[i]);
+			}
+			digitalWrite(_latchPin, HIGH);
+			SPI.endTransaction();
+		}
+
+	private:
+		int												_latchPin;
+		bool											_started;
+		uint8_t											_digitalValues[numberOfShiftRegisters];
+};
+
+#endif
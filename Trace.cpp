@@ -0,0 +1,167 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#include "Trace.h"
+
+#if useTrace
+
+TraceEvent		Trace::_events[nTraceEvents];
+uint8_t			Trace::_first			= 0;
+uint8_t			Trace::_count			= 0;
+unsigned long	Trace::_overwritten		= 0;
+unsigned long	Trace::_lastTime		= 0;
+unsigned long	Trace::_baseTime		= 0;
+bool			Trace::_dumping			= false;
+uint8_t			Trace::_dumpLine		= 0;
+
+void Trace::begin()
+{
+	_first			= 0;
+	_count			= 0;
+	_overwritten	= 0;
+	_lastTime		= HAL::micros() / traceTickTime;
+	_baseTime		= _lastTime;
+	_dumping		= false;
+}
+
+void Trace::record(TRACE::EVENT event, uint8_t payload)
+{
+	record(event, payload, HAL::micros());
+}
+
+void Trace::record(TRACE::EVENT event, uint8_t payload, unsigned long time)
+{
+	if (_dumping)
+	{
+		return;
+	}
+
+	// An event from before the last one recorded (an input sampled before it was handled) is put at the same time.
+	// The tick counter wraps with micros, at 2^32 microseconds.
+	const unsigned long tickMask = 0xFFFFFFFFUL / traceTickTime;
+
+	unsigned long ticks = (time / traceTickTime) & tickMask;
+	unsigned long delta = (ticks - _lastTime) & tickMask;
+	if (delta > tickMask / 2)
+	{
+		delta = 0;
+	}
+	else
+	{
+		_lastTime = ticks;
+	}
+
+	if (delta > 0xFFFF)
+	{
+		add(TRACE::GAP, 0, delta >> 16);
+		delta &= 0xFFFF;
+	}
+
+	add(event, payload, delta);
+}
+
+void Trace::dump()
+{
+	_dumping	= true;
+	_dumpLine	= 0;
+}
+
+bool Trace::isDumping()
+{
+	return _dumping;
+}
+
+void Trace::update()
+{
+	if (!_dumping)
+	{
+		return;
+	}
+
+	// Only whole lines go into the log, so wait until there is room for the longest (the header).
+	if (Log::getFree() < 48)
+	{
+		return;
+	}
+
+	if (_dumpLine == 0)
+	{
+		Log::print(F("TRACE BEGIN "));
+		Log::print(_baseTime * traceTickTime);
+		Log::print(" ");
+		Log::print((unsigned int)_count);
+		Log::print(" ");
+		Log::printLn(_overwritten);
+	}
+	else if (_dumpLine <= _count)
+	{
+		const TraceEvent& event = _events[(_first + _dumpLine - 1) % nTraceEvents];
+
+		char text[9];
+		printHex(event.event, text);
+		printHex(event.payload, text + 2);
+		printHex(event.delta >> 8, text + 4);
+		printHex(event.delta & 0xFF, text + 6);
+		text[8] = '\0';
+
+		Log::print(F("TRACE "));
+		Log::printLn(text);
+	}
+	else
+	{
+		Log::printLn(F("TRACE END"));
+
+		// Start over with the events that come after the dump.
+		_first			= 0;
+		_count			= 0;
+		_overwritten	= 0;
+		_baseTime		= _lastTime;
+		_dumping		= false;
+		return;
+	}
+
+	_dumpLine++;
+}
+
+void Trace::add(TRACE::EVENT event, uint8_t payload, uint16_t delta)
+{
+	if (_count == nTraceEvents)
+	{
+		// Full, so the oldest event is dropped.  Its time moves into the base time so the times of the rest are kept.
+		const TraceEvent& oldest = _events[_first];
+		_baseTime += oldest.event == TRACE::GAP ? (unsigned long)oldest.delta << 16 : oldest.delta;
+		_first		= (_first + 1) % nTraceEvents;
+		_count--;
+		_overwritten++;
+	}
+
+	TraceEvent& newest	= _events[(_first + _count) % nTraceEvents];
+	newest.event		= event;
+	newest.payload		= payload;
+	newest.delta		= delta;
+	_count++;
+}
+
+void Trace::printHex(uint8_t value, char* text)
+{
+	uint8_t high	= value >> 4;
+	uint8_t low		= value & 0x0F;
+	text[0]			= high < 10 ? '0' + high : 'A' + high - 10;
+	text[1]			= low < 10 ? '0' + low : 'A' + low - 10;
+}
+
+#endif
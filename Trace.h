@@ -0,0 +1,97 @@
+/*
+	Copyright (c) 2019 Lance A. Endres
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the Attribution-NonCommercial 4.0 International
+	(CC BY-NC 4.0) license as published by the Creative Commons Corporation
+	or (at your option) any later version.
+
+	You may not use this software for commercial works or profit from it.
+	
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+	https://creativecommons.org/licenses/by-nc/4.0/legalcode
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "HardwareAbstraction.h"
+#include "Configuration.h"
+#include "Log.h"
+
+// Record a trace event.  Compiled out completely when the trace is turned off.
+#if useTrace
+	#define traceEvent(event, payload)				Trace::record(event, payload)
+	#define traceEventAt(event, payload, time)		Trace::record(event, payload, time)
+#else
+	#define traceEvent(event, payload)				do { } while (0)
+	#define traceEventAt(event, payload, time)		do { } while (0)
+#endif
+
+// Time unit of the trace (microseconds).  A 16 bit delta covers about 1 second.
+#define traceTickTime 16
+
+// One recorded event.  The time is the number of ticks since the previous event.
+struct TraceEvent
+{
+	TRACE::EVENT				event;
+	uint8_t						payload;
+	uint16_t					delta;
+};
+
+// A flight recorder for timing events.  Recording an event costs a few microseconds and does not touch the serial port,
+// so turning it on does not change the timing it is recording.  The buffer is dumped on request as lines of text that
+// are sent out through the debug log a line at a time:
+//
+//	TRACE BEGIN <time of the first event's predecessor, microseconds> <number of events> <events overwritten>
+//	TRACE <event, 2 hex digits><payload, 2 hex digits><delta, 4 hex digits>
+//	...
+//	TRACE END
+//
+// Nothing is recorded while a dump is running.  A dump empties the buffer.
+//
+// Only used from the loop (not from interrupts).
+class Trace
+{
+	// Public interface.
+	public:
+		static void begin();
+
+		// Record an event now, or at an earlier time (microseconds, from micros).
+		static void record(TRACE::EVENT event, uint8_t payload);
+		static void record(TRACE::EVENT event, uint8_t payload, unsigned long time);
+
+		// Start sending the trace out.
+		static void dump();
+		static bool isDumping();
+
+		// Send the next part of a dump if there is room in the debug log.  Call from the loop.
+		static void update();
+
+	private:
+		static void add(TRACE::EVENT event, uint8_t payload, uint16_t delta);
+		static void printHex(uint8_t value, char* text);
+
+	private:
+		static TraceEvent									_events[nTraceEvents];
+		static uint8_t										_first;
+		static uint8_t										_count;
+		static unsigned long								_overwritten;
+
+		// The time of the most recent event and of the event before the first one kept (ticks).
+		static unsigned long								_lastTime;
+		static unsigned long								_baseTime;
+
+		// Dump progress.  The header is line 0.
+		static bool											_dumping;
+		static uint8_t										_dumpLine;
+
+	public:
+		// RAM (bytes) taken by the static data (when useTrace is on).
+		static constexpr unsigned int staticBytes = sizeof(_events) + sizeof(_first) + sizeof(_count) + sizeof(_overwritten) + sizeof(_lastTime) + sizeof(_baseTime) + sizeof(_dumping) + sizeof(_dumpLine);
+};
+
+#endif
@@ -42,13 +42,29 @@ namespace GENERATOR
 	};
 }
 
-// These are the light positions on the shift register.  The following rules must be followed:
+// Bits of the debounced inputs (see InputCapture).  The state sensors come first, in GENERATOR::STATE order, followed by
+// the buttons.
+namespace INPUTBIT
+{
+	enum BIT
+	{
+		MODEBUTTON			= GENERATOR::NUMBEROFSTATES,
+		BATTERYMETERBUTTON,
+		NUMBEROFINPUTS
+	};
+
+	// The bits of the state sensors.
+	const uint8_t SENSORMASK = (1 << GENERATOR::NUMBEROFSTATES) - 1;
+}
+
+// These are the lights on the shift registers.  Which output each one is wired to is set by the output map of the
+// profile (see Configuration.h).  The following rules must be followed:
 // 1) The enum must start at zero and be consecutive.  I.e., don't try to assign values to the enums.
 // 2) The blue lights must be in order and consecutive.
 namespace LIGHT
 {
-	// These lights are connected to a shift register.  The value of the enumeration
-	// is the postion on the shift register.
+	// These lights are connected to a shift register.  The value of the enumeration is the place of the light in the
+	// output map.
 	enum SHIFTREGISTER
 	{
 
@@ -68,10 +84,20 @@ namespace LIGHT
 		OFF   = LOW,
 		ON    = HIGH
 	};
+
+	const uint8_t NUMBEROFBLUELIGHTS = BLUE5 - BLUE1 + 1;
+
+	// Bit masks of the shift register outputs (bit n is output n).  Patterns of several lights are set with one masked
+	// write of the outputs.  The masks of the lights are worked out from the output map by the profile.
+	typedef uint16_t MASK;
+
+	constexpr MASK maskOf(uint8_t output)
+	{
+		return (MASK)1 << output;
+	}
 }
 
-// These are the other (non-light) outputs.  These and the light positions need to be consecutive when
-// using the shift registers for output.
+// These are the other (non-light) outputs.  They follow the lights in the output map of the profile.
 namespace AUDIO
 {
 	enum SHIFTREGISTER
@@ -82,6 +108,183 @@ namespace AUDIO
 		RANDOM,
 		UG,
 		STATECHANGE,
+		OVERLOAD,		// Only wired when useOverloadTrigger is on (see Configuration.h).
+		NUMBEROFOUTPUTS		// The lights and the audio lines, the size of the output map.
+	};
+}
+
+// Commands sent to the audio board over its serial port (see AudioQueue).
+namespace AUDIOCOMMAND
+{
+	// How important a sound played over the audio serial port is.  A sound interrupts one of the same or lower priority
+	// and waits for one of higher priority to finish.
+	enum PRIORITY : uint8_t
+	{
+		// Background sounds (the generator hum).
+		AMBIENT,
+
+		// Short effects (overload).
+		EFFECT,
+
+		// The arm moving to a new position.
+		STATECHANGE,
+	};
+
+	// What the queue is doing with the board.
+	enum STATE : uint8_t
+	{
+		// Nothing sent, waiting for a command.
+		IDLE,
+
+		// Sending the play command, then waiting for the board to start the file.
+		SENDING,
+		WAITING,
+	};
+}
+
+// Actions that can be stored in a light sequence step.  The step value is interpreted based on the action.  There can be
+// at most 16 because they are packed into 4 bits.
+namespace ANIMATION
+{
+	enum ACTION : uint8_t
+	{
+		// Do nothing.  Used to insert a pause into a sequence.
+		WAIT,
+
+		// Turn a single light on or off.  The value is the shift register position of the light.
+		LIGHTON,
+		LIGHTOFF,
+
+		// Turn on the specified number of blue lights (value) or turn them all off.
+		BLUELIGHTSON,
+		BLUELIGHTSOFF,
+
+		// Ready indicator light.
+		READYON,
+		READYOFF,
+
+		// Force an update of the battery meter lights.
+		BATTERYMETER,
+
+		// Set the brightness of all the lights (value).  Only has an effect when the brightness engine is turned on.
+		BRIGHTNESS,
+
+		// Pulse an audio trigger (value is its shift register position).
+		AUDIOTRIGGER,
+
+		// Flow control, handled by the sequence player and never applied.  The steps between REPEAT and LOOP are played
+		// the number of times given by the value of REPEAT.  Repeats can't be nested.  SYNC waits for a sound to start
+		// and times the steps after it from the start of the sound.  END finishes the sequence.
+		REPEAT,
+		LOOP,
+		SYNC,
+		END
+	};
+
+	// A step value that is replaced by the argument the sequence was started with.
+	enum OPERAND : uint8_t
+	{
+		ARGUMENT = 0xFF
+	};
+}
+
+// The generator has two state machines, the arm position and the special mode (only used in the off position).
+namespace STATEMACHINE
+{
+	enum MACHINE : uint8_t
+	{
+		GENERATORSTATE,
+		SPECIALMODE
+	};
+}
+
+// The timers of the generator (see Scheduler).  When several are due at once, they run in this order.
+namespace SCHEDULER
+{
+	enum TIMER : uint8_t
+	{
+		// The next step of the light sequence that is playing.
+		ANIMATION,
+
+		// The next change of an audio trigger line.
+		AUDIOPULSES,
+
+		// The next step of the scrolling blue light (ON state).
+		LIGHTSTEP,
+
+		// Refresh of the battery meter lights (battery meter special mode).
+		BATTERYMETER,
+
+		// Pick up the latest battery reading.
+		BATTERYSAMPLE,
+
+		// Blink of the ready indicator when the battery is low.
+		BATTERYWARNING,
+
+		NUMBEROFTIMERS
+	};
+}
+
+// Events recorded in the trace.  The meaning of the payload depends on the event.
+namespace TRACE
+{
+	enum EVENT : uint8_t
+	{
+		// Time passing with nothing recorded.  The time delta of this event is in units of 65536 ticks.
+		GAP,
+
+		// A change of the state sensors.  The payload has a bit set for each active sensor (bit 0 is OFF).  The time is
+		// when the change was sampled.
+		INPUTEDGE,
+
+		// The generator state (payload) was changed.
+		STATECHANGE,
+
+		// The special mode (payload) was changed.
+		SPECIALMODE,
+
+		// The scrolling blue light moved to a new light (payload, its shift register position).
+		BLUELIGHT,
+
+		// An audio trigger changed.  The payload is the shift register position, with the level in the high bit.
+		AUDIOTRIGGER,
+
+		// The overload ramp entered a new phase (payload).
+		OVERLOADPHASE,
+
+		NUMBEROFEVENTS
+	};
+}
+
+// Overload ramp of the blue lights in the ON state.
+namespace OVERLOAD
+{
+	// How the scroll speed moves from where it is to a new overload level over the ramp.
+	enum CURVE : uint8_t
+	{
+		// Constant change of the step time.
+		LINEAR,
+
+		// Starts slowly and surges at the end.
+		EASEIN,
+
+		// Jumps away quickly and settles gently.
+		EASEOUT,
+
+		// Slow at both ends.
+		SMOOTHSTEP
+	};
+
+	enum PHASE : uint8_t
+	{
+		// Running at the overload level that was asked for.
+		STEADY,
+
+		// Moving to a new overload level.
+		RAMPING,
+
+		// Running at full overload.
+		CRITICAL
 	};
 }
 